@@ -0,0 +1,129 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "queue/s_multi_queue.h"
+#include "queue/s_ordered_queue.h"
+
+/**
+ * @brief Elements queued before the runs, so the heaps are not trivial
+ */
+#define _PRELOAD 100000
+
+/**
+ * @brief Push and pop pairs per thread and run
+ */
+#define _OPS 1000000
+
+/**
+ * @brief Range of the random priorities
+ */
+#define _KEYS 1000000
+
+/**
+ * @brief The queues under test, the ordered queue behind one mutex
+ */
+static struct s_multi_queue *_multi;
+static struct s_ordered_queue *_ordered;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int _compare(void *a, void *b)
+{
+	intptr_t x = (intptr_t)a;
+	intptr_t y = (intptr_t)b;
+
+	return (x > y) - (x < y);
+}
+
+static void *_run_multi(void *data)
+{
+	unsigned int seed = (uintptr_t)data * 31 + 7;
+
+	for (int i = 0; i < _OPS; i++) {
+		intptr_t key = rand_r(&seed) % _KEYS + 1;
+
+		s_multi_queue_push(_multi, _compare, (void *)key);
+		s_multi_queue_pop(_multi, _compare);
+	}
+	return NULL;
+}
+
+static void *_run_ordered(void *data)
+{
+	unsigned int seed = (uintptr_t)data * 31 + 7;
+
+	for (int i = 0; i < _OPS; i++) {
+		intptr_t key = rand_r(&seed) % _KEYS + 1;
+
+		pthread_mutex_lock(&_lock);
+		s_ordered_queue_push(_ordered, _compare, (void *)key);
+		pthread_mutex_unlock(&_lock);
+		pthread_mutex_lock(&_lock);
+		s_ordered_queue_pop(_ordered, _compare);
+		pthread_mutex_unlock(&_lock);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Run a worker function on a number of threads
+ * @return the elapsed time in seconds
+ */
+static double _time(void *(*func)(void *), uint32_t threads)
+{
+	pthread_t thread[threads];
+	struct timespec start;
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_create(&thread[i], NULL, func, (void *)(uintptr_t)i);
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_join(thread[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t threads = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4;
+	unsigned int seed = 1;
+
+	_multi = s_multi_queue_new(e_ordered_increase, 0);
+	_ordered = s_ordered_queue_new(e_ordered_increase);
+	for (int i = 0; i < _PRELOAD; i++) {
+		intptr_t key = rand_r(&seed) % _KEYS + 1;
+
+		s_multi_queue_push(_multi, _compare, (void *)key);
+		s_ordered_queue_push(_ordered, _compare, (void *)key);
+	}
+
+	printf("%d push/pop pairs per thread, %d elements queued\n", _OPS,
+		_PRELOAD);
+	for (uint32_t i = 1; i <= threads; i <<= 1)
+		printf("%u threads: mutex s_ordered_queue %.2fs, "
+			"s_multi_queue %.2fs\n", i, _time(_run_ordered, i),
+			_time(_run_multi, i));
+
+	s_multi_queue_delete(_multi);
+	s_ordered_queue_delete(_ordered);
+	return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "list/s_skip_map.h"
+#include "tree/s_rb_tree.h"
+
+/**
+ * @brief Range of the keys, half of them stored before the runs
+ */
+#define _KEYS 100000
+
+/**
+ * @brief Operations per thread and run: 80% get, 10% put, 10% remove
+ */
+#define _OPS 1000000
+
+/**
+ * @brief The maps under test, the red/black tree behind one mutex
+ */
+static struct s_skip_map *_skip;
+static struct s_rb_tree *_tree;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int _compare(void *a, void *b)
+{
+	intptr_t x = (intptr_t)a;
+	intptr_t y = (intptr_t)b;
+
+	return (x > y) - (x < y);
+}
+
+static void *_run_skip(void *data)
+{
+	unsigned int seed = (uintptr_t)data * 31 + 7;
+
+	for (int i = 0; i < _OPS; i++) {
+		void *key = (void *)(intptr_t)(rand_r(&seed) % _KEYS + 1);
+		int op = rand_r(&seed) % 10;
+
+		if (op == 0)
+			s_skip_map_put(_skip, _compare, key, key);
+		else if (op == 1)
+			s_skip_map_remove(_skip, _compare, key);
+		else
+			s_skip_map_get(_skip, _compare, key);
+	}
+	return NULL;
+}
+
+static void *_run_tree(void *data)
+{
+	unsigned int seed = (uintptr_t)data * 31 + 7;
+
+	for (int i = 0; i < _OPS; i++) {
+		void *key = (void *)(intptr_t)(rand_r(&seed) % _KEYS + 1);
+		int op = rand_r(&seed) % 10;
+
+		pthread_mutex_lock(&_lock);
+		if (op == 0) {
+			if (!s_rb_tree_find(_tree, _compare, key))
+				_tree = s_rb_tree_add(_tree, _compare, key);
+		} else if (op == 1) {
+			_tree = s_rb_tree_remove(_tree, _compare, NULL, key);
+		} else {
+			s_rb_tree_find(_tree, _compare, key);
+		}
+		pthread_mutex_unlock(&_lock);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Run a worker function on a number of threads
+ * @return the elapsed time in seconds
+ */
+static double _time(void *(*func)(void *), uint32_t threads)
+{
+	pthread_t thread[threads];
+	struct timespec start;
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_create(&thread[i], NULL, func, (void *)(uintptr_t)i);
+	for (uint32_t i = 0; i < threads; i++)
+		pthread_join(thread[i], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start.tv_sec) +
+		(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t threads = (argc > 1) ? strtoul(argv[1], NULL, 10) : 4;
+
+	_skip = s_skip_map_new(NULL);
+	for (intptr_t key = 1; key <= _KEYS; key += 2) {
+		s_skip_map_put(_skip, _compare, (void *)key, (void *)key);
+		_tree = s_rb_tree_add(_tree, _compare, (void *)key);
+	}
+
+	printf("%d operations per thread, 80%% get, 10%% put, 10%% remove\n",
+		_OPS);
+	for (uint32_t i = 1; i <= threads; i <<= 1)
+		printf("%u threads: mutex s_rb_tree %.2fs, s_skip_map %.2fs\n",
+			i, _time(_run_tree, i), _time(_run_skip, i));
+
+	s_skip_map_delete(_skip);
+	if (_tree)
+		s_rb_tree_delete(_tree);
+	return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_LIST_S_SKIP_MAP_H_
+# define _TOOLS_INCLUDE_LIST_S_SKIP_MAP_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The concurrent key/value map structure (opaque), ordered by key. The
+ * map is a lazy skip list: lookups and range walks take no lock and never
+ * wait, updates only lock the few nodes around the entry changed. Any number
+ * of threads may use the map concurrently; the removed entries are freed once
+ * no thread can read them anymore (epoch based reclamation).
+ */
+export struct s_skip_map;
+
+/**
+ * @brief Allocate a new concurrent map instance
+ * @param key_destroy[in] : destroy function of the keys removed, called once
+ * no thread can read them anymore (may be NULL)
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_skip_map *s_skip_map_new(t_destroy_func key_destroy);
+
+/**
+ * @brief Deallocate a concurrent map instance. No other thread may use the map
+ * anymore.
+ * @param map[in] : instance to delete
+ * @note that function only delete the container, not the keys and values
+ * still in the map. To do that, use s_skip_map_delete_full() instead
+ */
+export void s_skip_map_delete(struct s_skip_map *map);
+
+/**
+ * @brief Deallocate a concurrent map instance, its keys and its values. No
+ * other thread may use the map anymore.
+ * @param map[in] : instance to delete
+ * @param value_destroy[in] : destroy function of the values (may be NULL)
+ */
+export void s_skip_map_delete_full(struct s_skip_map *map,
+	t_destroy_func value_destroy);
+
+/**
+ * @brief Get the number of entries of the map
+ * @param map[in] : map to investigate
+ * @return the number of entries
+ * @note the result may be outdated when returned
+ */
+export uint32_t s_skip_map_size(struct s_skip_map *map);
+
+/**
+ * @brief Get the value of a key, without any lock
+ * @param map[in] : map to browse
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @return the value, NULL if not found
+ */
+export void *s_skip_map_get(struct s_skip_map *map, t_compare_func compare,
+	void *key);
+
+/**
+ * @brief Check if a key is into the map, without any lock
+ * @param map[in] : map to browse
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @return 0 if found, -EAGAIN if not found, -errno on error
+ */
+export int s_skip_map_exist(struct s_skip_map *map, t_compare_func compare,
+	void *key);
+
+/**
+ * @brief Set the value of a key, adding the entry if needed. The key already
+ * stored is kept when the entry exists.
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key of the entry
+ * @param value[in] : new value
+ * @return the previous value, NULL if the entry has been added
+ */
+export void *s_skip_map_put(struct s_skip_map *map, t_compare_func compare,
+	void *key, void *value);
+
+/**
+ * @brief Add an entry if its key is not into the map yet
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key of the entry
+ * @param value[in] : value of the entry
+ * @return 0 on success, -EEXIST if the key is already into the map, -errno on
+ * error
+ */
+export int s_skip_map_add(struct s_skip_map *map, t_compare_func compare,
+	void *key, void *value);
+
+/**
+ * @brief Remove the entry of a key. The key stored is given to the key
+ * destroy function of the map once no thread can read it anymore.
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key to remove
+ * @return the value of the entry removed, NULL if not found
+ */
+export void *s_skip_map_remove(struct s_skip_map *map, t_compare_func compare,
+	void *key);
+
+/**
+ * @brief Browse the entries of the map in key order, without any lock
+ * @param map[in] : instance to browse
+ * @param foreach[in] : user callback for each entry
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ * @note the entries added or removed during the walk may be seen or not, the
+ * callback may modify the map
+ */
+export int s_skip_map_foreach(struct s_skip_map *map,
+	t_map_foreach_func foreach, void *user_data);
+
+/**
+ * @brief Browse in key order the entries between two keys (both included),
+ * without any lock, in O(log n + k) for k entries visited
+ * @param map[in] : instance to browse
+ * @param compare[in] : function to compare keys
+ * @param lo[in] : lower bound of the range
+ * @param hi[in] : upper bound of the range
+ * @param foreach[in] : user callback for each entry
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ * @note same consistency as s_skip_map_foreach()
+ */
+export int s_skip_map_foreach_range(struct s_skip_map *map,
+	t_compare_func compare, void *lo, void *hi, t_map_foreach_func foreach,
+	void *user_data);
+
+#endif /* !_TOOLS_INCLUDE_LIST_S_SKIP_MAP_H_ */
@@ -0,0 +1,85 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_LIST_S_WS_DEQUE_H_
+# define _TOOLS_INCLUDE_LIST_S_WS_DEQUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The work-stealing deque structure (opaque). This is a Chase-Lev
+ * deque: a single owner thread push and pop at the bottom, while any other
+ * thread may steal at the top.
+ */
+export struct s_ws_deque;
+
+/**
+ * @brief Allocate a new work-stealing deque instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_ws_deque *s_ws_deque_new(void);
+
+/**
+ * @brief Deallocate a work-stealing deque instance.
+ * @param deque[in] : deque to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_ws_deque_delete_full() instead. No other thread should
+ * access the deque anymore.
+ */
+export void s_ws_deque_delete(struct s_ws_deque *deque);
+
+/**
+ * @brief Deallocate a work-stealing deque instance and user pointer too
+ * @param deque[in] : deque to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_ws_deque_delete_full(struct s_ws_deque *deque,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the deque contains elements. The result is only a hint when
+ * other threads are stealing concurrently.
+ * @param deque[in] : deque to investigate
+ * @return a 0 if the deque contained element, 1 all other case
+ */
+export uint8_t s_ws_deque_empty(const struct s_ws_deque *deque);
+
+/**
+ * @brief Add an element data at the bottom of the deque (owner only)
+ * @param deque[in] : deque to modify
+ * @param data[in] : data to push
+ * @return 0 on success, -errno on error
+ */
+export int s_ws_deque_push(struct s_ws_deque *deque, void *data);
+
+/**
+ * @brief Remove an element from the bottom of the deque (owner only)
+ * @param deque[in] : deque to modify
+ * @return a data pointer on success, NULL on error or if empty
+ */
+export void *s_ws_deque_pop(struct s_ws_deque *deque);
+
+/**
+ * @brief Remove an element from the top of the deque (any thread)
+ * @param deque[in] : deque to steal from
+ * @return a data pointer on success, NULL on error, if empty or if the element
+ * was taken by a concurrent thread
+ */
+export void *s_ws_deque_steal(struct s_ws_deque *deque);
+
+#endif /* !_TOOLS_INCLUDE_LIST_S_WS_DEQUE_H_ */
@@ -35,6 +35,16 @@ void *_calloc(uint32_t size, uint32_t nbr);
  */
 void *_malloc(uint32_t size);
 
+/**
+ * @brief use to protect user against allocator's error, the memory is
+ * released with _free()
+ * @param align[in] : alignment in byte (power of 2, multiple of
+ * sizeof(void *))
+ * @param size[in] : nbr of byte (sizeof() result)
+ * @return a valid pointer or assert
+ */
+void *_aligned_malloc(uint32_t align, uint32_t size);
+
 /**
  * @brief use to protect user against allocator's error
  * @param ptr[in] : old pointer value
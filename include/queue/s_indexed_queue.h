@@ -0,0 +1,149 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_INDEXED_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_INDEXED_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+# include "queue/s_ordered_queue.h"
+
+/**
+ * @brief The indexed queue structure (opaque). Like s_ordered_queue, but each
+ * element pushed gets a handle which can be used to change its priority or to
+ * remove it. A handle is valid until its element is popped or erased, it may
+ * then be reused by a later push.
+ */
+export struct s_indexed_queue;
+
+/**
+ * @brief Allocate a new indexed queue instance
+ * @param ordering[in] : ordering of the queue
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_indexed_queue *s_indexed_queue_new(enum e_ordered ordering);
+
+/**
+ * @brief Deallocate an indexed queue instance.
+ * @param queue[in] : queue to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_indexed_queue_delete_full() instead
+ */
+export void s_indexed_queue_delete(struct s_indexed_queue *queue);
+
+/**
+ * @brief Deallocate an indexed queue instance and user pointer too
+ * @param queue[in] : queue to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_indexed_queue_delete_full(struct s_indexed_queue *queue,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the queue contains elements
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained element, 1 all other case
+ */
+export uint8_t s_indexed_queue_empty(const struct s_indexed_queue *queue);
+
+/**
+ * @brief Get the number of elements in the queue
+ * @param queue[in] : queue to investigate
+ * @return the number of elements
+ */
+export uint32_t s_indexed_queue_size(const struct s_indexed_queue *queue);
+
+/**
+ * @brief Add an element data into the queue
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : data to push
+ * @param handle[out] : optional, handle of the element
+ * @return 0 on success, -errno on error
+ */
+export int s_indexed_queue_push(struct s_indexed_queue *queue,
+	t_compare_func cmp, void *data, uint32_t *handle);
+
+/**
+ * @brief Get the next element to be popped without removing it
+ * @param queue[in] : queue to investigate
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_indexed_queue_peek(const struct s_indexed_queue *queue);
+
+/**
+ * @brief Remove the next element from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_indexed_queue_pop(struct s_indexed_queue *queue,
+	t_compare_func cmp);
+
+/**
+ * @brief Get the data of an element
+ * @param queue[in] : queue to investigate
+ * @param handle[in] : element handle
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_indexed_queue_get(const struct s_indexed_queue *queue,
+	uint32_t handle);
+
+/**
+ * @brief Signal that the key of an element became smaller
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param handle[in] : element handle
+ * @param data[in] : new data of the element (may be the same pointer)
+ * @return 0 on success, -errno on error
+ */
+export int s_indexed_queue_decrease_key(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle, void *data);
+
+/**
+ * @brief Signal that the key of an element became bigger
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param handle[in] : element handle
+ * @param data[in] : new data of the element (may be the same pointer)
+ * @return 0 on success, -errno on error
+ */
+export int s_indexed_queue_increase_key(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle, void *data);
+
+/**
+ * @brief Change the key of an element in any direction
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param handle[in] : element handle
+ * @param data[in] : new data of the element (may be the same pointer)
+ * @return 0 on success, -errno on error
+ */
+export int s_indexed_queue_update(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle, void *data);
+
+/**
+ * @brief Remove an element from the queue
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param handle[in] : element handle
+ * @return the data removed on success, NULL on error
+ */
+export void *s_indexed_queue_erase(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_INDEXED_QUEUE_H_ */
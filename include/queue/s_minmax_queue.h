@@ -0,0 +1,112 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_MINMAX_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_MINMAX_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The double-ended priority queue structure (opaque). Both the
+ * smallest and the biggest element can be peeked in O(1) and popped in
+ * O(log n) (min-max heap).
+ */
+export struct s_minmax_queue;
+
+/**
+ * @brief Allocate a new double-ended priority queue instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_minmax_queue *s_minmax_queue_new(void);
+
+/**
+ * @brief Deallocate a double-ended priority queue instance.
+ * @param queue[in] : queue to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_minmax_queue_delete_full() instead
+ */
+export void s_minmax_queue_delete(struct s_minmax_queue *queue);
+
+/**
+ * @brief Deallocate a double-ended priority queue instance and user pointer
+ * too
+ * @param queue[in] : queue to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_minmax_queue_delete_full(struct s_minmax_queue *queue,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the queue contains elements
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained element, 1 all other case
+ */
+export uint8_t s_minmax_queue_empty(const struct s_minmax_queue *queue);
+
+/**
+ * @brief Get the number of elements in the queue
+ * @param queue[in] : queue to investigate
+ * @return the number of elements
+ */
+export uint32_t s_minmax_queue_size(const struct s_minmax_queue *queue);
+
+/**
+ * @brief Add an element data into the queue
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : data to push
+ * @return 0 on success, -errno on error
+ */
+export int s_minmax_queue_push(struct s_minmax_queue *queue,
+	t_compare_func cmp, void *data);
+
+/**
+ * @brief Get the smallest element without removing it
+ * @param queue[in] : queue to investigate
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_minmax_queue_peek_min(const struct s_minmax_queue *queue);
+
+/**
+ * @brief Get the biggest element without removing it
+ * @param queue[in] : queue to investigate
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_minmax_queue_peek_max(const struct s_minmax_queue *queue,
+	t_compare_func cmp);
+
+/**
+ * @brief Remove the smallest element from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_minmax_queue_pop_min(struct s_minmax_queue *queue,
+	t_compare_func cmp);
+
+/**
+ * @brief Remove the biggest element from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_minmax_queue_pop_max(struct s_minmax_queue *queue,
+	t_compare_func cmp);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_MINMAX_QUEUE_H_ */
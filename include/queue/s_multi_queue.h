@@ -0,0 +1,92 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_MULTI_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_MULTI_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+# include "queue/s_ordered_queue.h"
+
+/**
+ * @brief The concurrent relaxed priority queue structure (opaque). The queue
+ * is a set of locked heaps (MultiQueue): push goes to a random heap, pop takes
+ * the best head of two random heaps. Any number of threads may push and pop
+ * concurrently; the order is only approximate, the relaxation growing with
+ * the number of heaps.
+ */
+export struct s_multi_queue;
+
+/**
+ * @brief Allocate a new concurrent relaxed priority queue instance
+ * @param ordering[in] : ordering of the queue
+ * @param heaps[in] : number of internal heaps, 0 to use two per online cpu.
+ * More heaps means less contention and a weaker ordering, 1 gives a strict
+ * (locked) priority queue
+ * @return a valid pointer on success, NULL on error
+ * @note the heaps only pay off with several cpus: on a single one, a thread
+ * preempted while holding a heap lock makes the others retry, and a locked
+ * s_ordered_queue (or 1 heap) is faster
+ */
+export struct s_multi_queue *s_multi_queue_new(enum e_ordered ordering,
+	uint32_t heaps);
+
+/**
+ * @brief Deallocate a concurrent relaxed priority queue instance.
+ * @param queue[in] : queue to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_multi_queue_delete_full() instead
+ */
+export void s_multi_queue_delete(struct s_multi_queue *queue);
+
+/**
+ * @brief Deallocate a concurrent relaxed priority queue instance and user
+ * pointer too
+ * @param queue[in] : queue to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_multi_queue_delete_full(struct s_multi_queue *queue,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the queue contains elements
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained element, 1 all other case
+ * @note the result may be outdated when returned
+ */
+export uint8_t s_multi_queue_empty(const struct s_multi_queue *queue);
+
+/**
+ * @brief Add an element data into the queue
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : data to push (not NULL)
+ * @return 0 on success, -errno on error
+ */
+export int s_multi_queue_push(struct s_multi_queue *queue, t_compare_func cmp,
+	void *data);
+
+/**
+ * @brief Remove one of the first elements from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error or if the queue is empty
+ */
+export void *s_multi_queue_pop(struct s_multi_queue *queue,
+	t_compare_func cmp);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_MULTI_QUEUE_H_ */
@@ -30,16 +30,42 @@ export enum e_ordered {
 };
 
 /**
- * @brief The ordered queue structure (opaque)
+ * @brief The ordered queue structure (opaque). The queue is an array based
+ * d-ary heap: e_ordered_increase pops the smallest element first,
+ * e_ordered_decrease the biggest one.
  */
 export struct s_ordered_queue;
 
 /**
  * @brief Allocate a new ordered queue instance
+ * @param ordering[in] : ordering of the queue
  * @return a valid pointer on success, NULL on error
  */
 export struct s_ordered_queue *s_ordered_queue_new(enum e_ordered ordering);
 
+/**
+ * @brief Allocate a new ordered queue instance with a specific heap arity.
+ * A bigger arity makes push cheaper and pop more expensive.
+ * @param ordering[in] : ordering of the queue
+ * @param arity[in] : number of children per heap element (>= 2)
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_ordered_queue *s_ordered_queue_new_with_arity(
+	enum e_ordered ordering, uint8_t arity);
+
+/**
+ * @brief Allocate a new ordered queue instance filled with the elements of an
+ * array, in O(n)
+ * @param ordering[in] : ordering of the queue
+ * @param cmp[in] : comparison operator
+ * @param data[in] : elements to push (the array is copied)
+ * @param size[in] : number of elements
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_ordered_queue *s_ordered_queue_new_from_array(
+	enum e_ordered ordering, t_compare_func cmp, void **data,
+	uint32_t size);
+
 /**
  * @brief Deallocate an ordered queue instance.
  * @param queue[in] : queue to delete
@@ -63,6 +89,20 @@ export void s_ordered_queue_delete_full(struct s_ordered_queue *queue,
  */
 export uint8_t s_ordered_queue_empty(const struct s_ordered_queue *queue);
 
+/**
+ * @brief Get the number of elements in the queue
+ * @param queue[in] : queue to investigate
+ * @return the number of elements
+ */
+export uint32_t s_ordered_queue_size(const struct s_ordered_queue *queue);
+
+/**
+ * @brief Get the next element to be popped without removing it
+ * @param queue[in] : queue to investigate
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_ordered_queue_peek(const struct s_ordered_queue *queue);
+
 /**
  * @brief Remove an element from the queue and return it
  * @param queue[in] : queue to modify
@@ -82,4 +122,16 @@ export void *s_ordered_queue_pop(struct s_ordered_queue *queue,
 export int s_ordered_queue_push(struct s_ordered_queue *queue,
 	t_compare_func cmp, void *data);
 
+/**
+ * @brief Add several elements into the queue. A big batch is merged by
+ * rebuilding the heap in linear time instead of pushing one by one.
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : elements to push
+ * @param size[in] : number of elements
+ * @return 0 on success, -errno on error
+ */
+export int s_ordered_queue_push_n(struct s_ordered_queue *queue,
+	t_compare_func cmp, void **data, uint32_t size);
+
 #endif /* !_TOOLS_INCLUDE_QUEUE_S_ORDERED_QUEUE_H_ */
@@ -0,0 +1,105 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_PAIRING_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_PAIRING_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+# include "queue/s_ordered_queue.h"
+
+/**
+ * @brief The meldable ordered queue structure (opaque). Same usage as
+ * s_ordered_queue, backed by a pairing heap: push and meld are O(1), pop is
+ * O(log n) amortized.
+ */
+export struct s_pairing_queue;
+
+/**
+ * @brief Allocate a new meldable ordered queue instance
+ * @param ordering[in] : ordering of the queue
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_pairing_queue *s_pairing_queue_new(enum e_ordered ordering);
+
+/**
+ * @brief Deallocate a meldable ordered queue instance.
+ * @param queue[in] : queue to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_pairing_queue_delete_full() instead
+ */
+export void s_pairing_queue_delete(struct s_pairing_queue *queue);
+
+/**
+ * @brief Deallocate a meldable ordered queue instance and user pointer too
+ * @param queue[in] : queue to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_pairing_queue_delete_full(struct s_pairing_queue *queue,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the queue contains elements
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained element, 1 all other case
+ */
+export uint8_t s_pairing_queue_empty(const struct s_pairing_queue *queue);
+
+/**
+ * @brief Get the number of elements in the queue
+ * @param queue[in] : queue to investigate
+ * @return the number of elements
+ */
+export uint32_t s_pairing_queue_size(const struct s_pairing_queue *queue);
+
+/**
+ * @brief Add an element data into the queue
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : data to push
+ * @return 0 on success, -errno on error
+ */
+export int s_pairing_queue_push(struct s_pairing_queue *queue,
+	t_compare_func cmp, void *data);
+
+/**
+ * @brief Get the next element to be popped without removing it
+ * @param queue[in] : queue to investigate
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_pairing_queue_peek(const struct s_pairing_queue *queue);
+
+/**
+ * @brief Remove an element from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_pairing_queue_pop(struct s_pairing_queue *queue,
+	t_compare_func cmp);
+
+/**
+ * @brief Move all the elements of a queue into another one in O(1)
+ * @param queue[in] : queue receiving the elements
+ * @param other[in] : queue to empty, with the same ordering
+ * @param cmp[in] : comparison operator
+ * @return 0 on success, -errno on error
+ */
+export int s_pairing_queue_meld(struct s_pairing_queue *queue,
+	struct s_pairing_queue *other, t_compare_func cmp);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_PAIRING_QUEUE_H_ */
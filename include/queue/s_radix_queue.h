@@ -0,0 +1,93 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_RADIX_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_RADIX_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The radix queue structure (opaque). A monotone priority queue on
+ * uint64_t keys (radix heap): the smallest key is popped first and a key
+ * pushed can not be smaller than the last key popped. No comparison function
+ * is involved, operations are amortized O(log C) with C the key range.
+ */
+export struct s_radix_queue;
+
+/**
+ * @brief Allocate a new radix queue instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_radix_queue *s_radix_queue_new(void);
+
+/**
+ * @brief Deallocate a radix queue instance.
+ * @param queue[in] : queue to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_radix_queue_delete_full() instead
+ */
+export void s_radix_queue_delete(struct s_radix_queue *queue);
+
+/**
+ * @brief Deallocate a radix queue instance and user pointer too
+ * @param queue[in] : queue to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_radix_queue_delete_full(struct s_radix_queue *queue,
+	t_destroy_func func);
+
+/**
+ * @brief Check if the queue contains elements
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained element, 1 all other case
+ */
+export uint8_t s_radix_queue_empty(const struct s_radix_queue *queue);
+
+/**
+ * @brief Get the number of elements in the queue
+ * @param queue[in] : queue to investigate
+ * @return the number of elements
+ */
+export uint32_t s_radix_queue_size(const struct s_radix_queue *queue);
+
+/**
+ * @brief Get the last key popped, the lower bound of the keys accepted
+ * @param queue[in] : queue to investigate
+ * @return a key
+ */
+export uint64_t s_radix_queue_last(const struct s_radix_queue *queue);
+
+/**
+ * @brief Add an element data into the queue
+ * @param queue[in] : queue to modify
+ * @param key[in] : priority, not smaller than s_radix_queue_last()
+ * @param data[in] : data to push
+ * @return 0 on success, -errno on error
+ */
+export int s_radix_queue_push(struct s_radix_queue *queue, uint64_t key,
+	void *data);
+
+/**
+ * @brief Remove an element with the smallest key from the queue and return it
+ * @param queue[in] : queue to modify
+ * @param key[out] : optional, key of the element
+ * @return a data pointer on success, NULL on error
+ */
+export void *s_radix_queue_pop(struct s_radix_queue *queue, uint64_t *key);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_RADIX_QUEUE_H_ */
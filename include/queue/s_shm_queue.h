@@ -0,0 +1,153 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_SHM_QUEUE_H_
+# define _TOOLS_INCLUDE_QUEUE_S_SHM_QUEUE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+
+/**
+ * @brief The shared memory queue structure (opaque). The queue is a ring of
+ * variable-length messages living in a shared mapping, with one producer and
+ * one consumer which may be in different processes. Only offsets are stored
+ * in the mapping so each process can map it at any address.
+ * @note the timeout parameters are in milliseconds: 0 return immediately,
+ * a negative value wait forever.
+ */
+export struct s_shm_queue;
+
+/**
+ * @brief Allocate a new shared memory queue
+ * @param name[in] : POSIX shared memory name (see shm_open()), or NULL for an
+ * anonymous memfd to share with s_shm_queue_fd() (fork or fd passing)
+ * @param size[in] : ring size in bytes, rounded up to a power of 2
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_shm_queue *s_shm_queue_new(const char *name, uint32_t size);
+
+/**
+ * @brief Map an existing shared memory queue by name
+ * @param name[in] : POSIX shared memory name given to s_shm_queue_new()
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_shm_queue *s_shm_queue_open(const char *name);
+
+/**
+ * @brief Map an existing shared memory queue from a file descriptor
+ * @param fd[in] : file descriptor (duplicated)
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_shm_queue *s_shm_queue_open_fd(int fd);
+
+/**
+ * @brief Unmap a shared memory queue. The shared memory itself is released
+ * when the last process unmap it and, for a named queue, once
+ * s_shm_queue_unlink() has been called.
+ * @param queue[in] : queue to delete
+ */
+export void s_shm_queue_delete(struct s_shm_queue *queue);
+
+/**
+ * @brief Remove the name of a shared memory queue
+ * @param name[in] : POSIX shared memory name
+ * @return 0 on success, -errno on error
+ */
+export int s_shm_queue_unlink(const char *name);
+
+/**
+ * @brief Get the file descriptor of the shared memory
+ * @param queue[in] : queue to investigate
+ * @return a file descriptor on success, -errno on error
+ */
+export int s_shm_queue_fd(const struct s_shm_queue *queue);
+
+/**
+ * @brief Get the biggest message the queue can hold
+ * @param queue[in] : queue to investigate
+ * @return a size in bytes on success, 0 on error
+ */
+export uint32_t s_shm_queue_max_size(const struct s_shm_queue *queue);
+
+/**
+ * @brief Check if the queue contains messages
+ * @param queue[in] : queue to investigate
+ * @return a 0 if the queue contained message, 1 all other case
+ */
+export uint8_t s_shm_queue_empty(const struct s_shm_queue *queue);
+
+/**
+ * @brief Reserve room for a message in the ring (producer only). The message
+ * is written in place then published with s_shm_queue_commit().
+ * @param queue[in] : queue to modify
+ * @param len[in] : message size
+ * @param data[out] : where to write the message
+ * @param timeout[in] : time to wait for room
+ * @return 0 on success, -errno on error (-EAGAIN or -ETIMEDOUT if full)
+ */
+export int s_shm_queue_reserve(struct s_shm_queue *queue, uint32_t len,
+	void **data, int32_t timeout);
+
+/**
+ * @brief Publish the message reserved (producer only)
+ * @param queue[in] : queue to modify
+ * @return 0 on success, -errno on error
+ */
+export int s_shm_queue_commit(struct s_shm_queue *queue);
+
+/**
+ * @brief Get the oldest message of the ring without copy (consumer only). The
+ * message stay valid until s_shm_queue_release() is called.
+ * @param queue[in] : queue to investigate
+ * @param data[out] : message
+ * @param timeout[in] : time to wait for a message
+ * @return the message size on success, -errno on error (-EAGAIN or
+ * -ETIMEDOUT if empty)
+ */
+export int s_shm_queue_peek(struct s_shm_queue *queue, void **data,
+	int32_t timeout);
+
+/**
+ * @brief Give back the room of the message peeked (consumer only)
+ * @param queue[in] : queue to modify
+ * @return 0 on success, -errno on error
+ */
+export int s_shm_queue_release(struct s_shm_queue *queue);
+
+/**
+ * @brief Copy a message into the queue (producer only)
+ * @param queue[in] : queue to modify
+ * @param data[in] : message
+ * @param len[in] : message size
+ * @param timeout[in] : time to wait for room
+ * @return 0 on success, -errno on error
+ */
+export int s_shm_queue_push(struct s_shm_queue *queue, const void *data,
+	uint32_t len, int32_t timeout);
+
+/**
+ * @brief Copy the oldest message out of the queue (consumer only)
+ * @param queue[in] : queue to modify
+ * @param data[out] : buffer receiving the message
+ * @param len[in] : buffer size
+ * @param timeout[in] : time to wait for a message
+ * @return the message size on success, -errno on error (-EMSGSIZE if the
+ * buffer is too small, the message is then left in the queue)
+ */
+export int s_shm_queue_pop(struct s_shm_queue *queue, void *data, uint32_t len,
+	int32_t timeout);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_SHM_QUEUE_H_ */
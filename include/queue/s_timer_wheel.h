@@ -0,0 +1,106 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_TIMER_WHEEL_H_
+# define _TOOLS_INCLUDE_QUEUE_S_TIMER_WHEEL_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The hierarchical timing wheel structure (opaque). Time is counted in
+ * ticks of any unit chosen by the user (ms, us, ...).
+ */
+export struct s_timer_wheel;
+
+/**
+ * @brief A timer scheduled into a wheel (opaque). The handle is valid until
+ * the timer fires or is cancelled.
+ */
+export struct s_timer;
+
+/**
+ * @brief Allocate a new timing wheel instance
+ * @param now[in] : current time in ticks
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_timer_wheel *s_timer_wheel_new(uint64_t now);
+
+/**
+ * @brief Deallocate a timing wheel instance.
+ * @param wheel[in] : wheel to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_timer_wheel_delete_full() instead
+ */
+export void s_timer_wheel_delete(struct s_timer_wheel *wheel);
+
+/**
+ * @brief Deallocate a timing wheel instance and the pending user pointer too
+ * @param wheel[in] : wheel to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_timer_wheel_delete_full(struct s_timer_wheel *wheel,
+	t_destroy_func func);
+
+/**
+ * @brief Check if timers are pending
+ * @param wheel[in] : wheel to investigate
+ * @return a 0 if the wheel contained timers, 1 all other case
+ */
+export uint8_t s_timer_wheel_empty(const struct s_timer_wheel *wheel);
+
+/**
+ * @brief Get the current time of the wheel
+ * @param wheel[in] : wheel to investigate
+ * @return the last time given to s_timer_wheel_advance()
+ */
+export uint64_t s_timer_wheel_now(const struct s_timer_wheel *wheel);
+
+/**
+ * @brief Schedule a timer in O(1). A timer already expired fires on the next
+ * tick.
+ * @param wheel[in] : wheel to modify
+ * @param expire[in] : expiration time in ticks
+ * @param data[in] : data given to the callback
+ * @return a timer handle on success, NULL on error
+ */
+export struct s_timer *s_timer_wheel_schedule(struct s_timer_wheel *wheel,
+	uint64_t expire, void *data);
+
+/**
+ * @brief Cancel a pending timer in O(1)
+ * @param wheel[in] : wheel to modify
+ * @param timer[in] : timer to cancel
+ * @return the timer data on success, NULL on error
+ */
+export void *s_timer_wheel_cancel(struct s_timer_wheel *wheel,
+	struct s_timer *timer);
+
+/**
+ * @brief Move the wheel forward and fire all the timers expired, in
+ * expiration order. Empty ranges of ticks are skipped.
+ * @param wheel[in] : wheel to modify
+ * @param now[in] : current time in ticks
+ * @param func[in] : callback called with the data of each timer expired
+ * @param user_data[in] : user data pass through the callback
+ * @return the bitwise or of the callback results, -errno on error
+ * @note the callback may schedule or cancel timers
+ */
+export int s_timer_wheel_advance(struct s_timer_wheel *wheel, uint64_t now,
+	t_foreach_func func, void *user_data);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_TIMER_WHEEL_H_ */
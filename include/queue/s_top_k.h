@@ -0,0 +1,106 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_QUEUE_S_TOP_K_H_
+# define _TOOLS_INCLUDE_QUEUE_S_TOP_K_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+# include "queue/s_ordered_queue.h"
+
+/**
+ * @brief The top-K collector structure (opaque). It keeps, out of a stream,
+ * the K elements an s_ordered_queue of the same ordering would pop first:
+ * e_ordered_increase keeps the K smallest, e_ordered_decrease the K biggest.
+ * Memory is O(K) and, once full, an element not better than the threshold is
+ * rejected with a single comparison.
+ */
+export struct s_top_k;
+
+/**
+ * @brief Allocate a new top-K collector instance
+ * @param ordering[in] : ordering of the elements
+ * @param k[in] : number of elements kept (> 0)
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_top_k *s_top_k_new(enum e_ordered ordering, uint32_t k);
+
+/**
+ * @brief Deallocate a top-K collector instance.
+ * @param top[in] : collector to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_top_k_delete_full() instead
+ */
+export void s_top_k_delete(struct s_top_k *top);
+
+/**
+ * @brief Deallocate a top-K collector instance and user pointer too
+ * @param top[in] : collector to delete
+ * @param func[in] : delete function associate to the user data
+ */
+export void s_top_k_delete_full(struct s_top_k *top, t_destroy_func func);
+
+/**
+ * @brief Get the number of elements kept
+ * @param top[in] : collector to investigate
+ * @return the number of elements, at most K
+ */
+export uint32_t s_top_k_size(const struct s_top_k *top);
+
+/**
+ * @brief Get the worst element kept: once the collector is full, an element
+ * must be better than it to get in
+ * @param top[in] : collector to investigate
+ * @return a data pointer on success, NULL on error or if empty
+ */
+export void *s_top_k_threshold(const struct s_top_k *top);
+
+/**
+ * @brief Offer an element to the collector
+ * @param top[in] : collector to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : element offered
+ * @return the element left out: data itself if rejected, the previous
+ * threshold if it was evicted, NULL if nothing was left out or on error
+ */
+export void *s_top_k_offer(struct s_top_k *top, t_compare_func cmp,
+	void *data);
+
+/**
+ * @brief Offer a batch of elements to the collector
+ * @param top[in] : collector to modify
+ * @param cmp[in] : comparison operator
+ * @param data[in] : elements offered
+ * @param size[in] : number of elements
+ * @param func[in] : optional, called on each element left out
+ * @return the number of elements left out on success, -errno on error
+ */
+export int s_top_k_offer_n(struct s_top_k *top, t_compare_func cmp,
+	void **data, uint32_t size, t_destroy_func func);
+
+/**
+ * @brief Move the elements kept into an array, best first, and empty the
+ * collector
+ * @param top[in] : collector to modify
+ * @param cmp[in] : comparison operator
+ * @param data[out] : array of at least s_top_k_size() elements
+ * @return the number of elements written on success, -errno on error
+ */
+export int s_top_k_drain(struct s_top_k *top, t_compare_func cmp,
+	void **data);
+
+#endif /* !_TOOLS_INCLUDE_QUEUE_S_TOP_K_H_ */
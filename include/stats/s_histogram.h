@@ -0,0 +1,102 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_STATS_S_HISTOGRAM_H_
+# define _TOOLS_INCLUDE_STATS_S_HISTOGRAM_H_
+
+# include <stdint.h>
+# include "m_export.h"
+
+/**
+ * @brief Log-linear (HDR style) histogram structure (opaque). Values are
+ * stored with a relative error below 3% up to 2^40, bigger values are
+ * saturated. Recording and reading can be done concurrently.
+ */
+export struct s_histogram;
+
+/**
+ * @brief Allocate a new histogram instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_histogram *s_histogram_new(void);
+
+/**
+ * @brief Deallocate a histogram instance
+ * @param histogram[in] : histogram to delete
+ */
+export void s_histogram_delete(struct s_histogram *histogram);
+
+/**
+ * @brief Clear all the values recorded
+ * @param histogram[in] : histogram to modify
+ */
+export void s_histogram_reset(struct s_histogram *histogram);
+
+/**
+ * @brief Record a value into the histogram
+ * @param histogram[in] : histogram to modify
+ * @param value[in] : value to record
+ * @return 0 on success, -errno on error
+ */
+export int s_histogram_record(struct s_histogram *histogram, uint64_t value);
+
+/**
+ * @brief Add all the values of a histogram into another one
+ * @param dst[in] : histogram to modify
+ * @param src[in] : histogram to add
+ * @return 0 on success, -errno on error
+ */
+export int s_histogram_merge(struct s_histogram *dst,
+	const struct s_histogram *src);
+
+/**
+ * @brief Get the number of values recorded
+ * @param histogram[in] : histogram to investigate
+ * @return a number of values on success, 0 on error
+ */
+export uint64_t s_histogram_count(const struct s_histogram *histogram);
+
+/**
+ * @brief Get the smallest value recorded
+ * @param histogram[in] : histogram to investigate
+ * @return a value on success, 0 on error or if empty
+ */
+export uint64_t s_histogram_min(const struct s_histogram *histogram);
+
+/**
+ * @brief Get the biggest value recorded
+ * @param histogram[in] : histogram to investigate
+ * @return a value on success, 0 on error or if empty
+ */
+export uint64_t s_histogram_max(const struct s_histogram *histogram);
+
+/**
+ * @brief Get the mean of the values recorded
+ * @param histogram[in] : histogram to investigate
+ * @return a value on success, 0 on error or if empty
+ */
+export double s_histogram_mean(const struct s_histogram *histogram);
+
+/**
+ * @brief Get the value at a given percentile
+ * @param histogram[in] : histogram to investigate
+ * @param percentile[in] : percentile between 0 and 100
+ * @return a value on success, 0 on error or if empty
+ */
+export uint64_t s_histogram_percentile(const struct s_histogram *histogram,
+	double percentile);
+
+#endif /* !_TOOLS_INCLUDE_STATS_S_HISTOGRAM_H_ */
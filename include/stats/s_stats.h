@@ -0,0 +1,112 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_STATS_S_STATS_H_
+# define _TOOLS_INCLUDE_STATS_S_STATS_H_
+
+# include <stdint.h>
+# include "stats/s_histogram.h"
+# include "m_export.h"
+
+/**
+ * @brief Container operations whose latency is recorded (in nanoseconds) when
+ * the library is configured with --enable-stats. The lookups of a container
+ * are all recorded as exist, its adds as add or push, the appends and
+ * prepends of a list as push and its removes as pop. The executor, the
+ * persistent red/black tree, the shared memory queue, the timer wheel and
+ * the top-K collector are not recorded.
+ */
+export enum e_stats_op {
+	e_stats_stack_push,
+	e_stats_stack_pop,
+	e_stats_queue_push,
+	e_stats_queue_pop,
+	e_stats_ordered_queue_push,
+	e_stats_ordered_queue_pop,
+	e_stats_ordered_queue_push_n,
+	e_stats_ws_deque_push,
+	e_stats_ws_deque_pop,
+	e_stats_ws_deque_steal,
+	e_stats_bs_tree_add,
+	e_stats_bs_tree_remove,
+	e_stats_bs_tree_exist,
+	e_stats_bs_tree_foreach,
+	e_stats_rb_tree_add,
+	e_stats_rb_tree_remove,
+	e_stats_rb_tree_exist,
+	e_stats_rb_tree_foreach,
+	e_stats_list_push,
+	e_stats_list_pop,
+	e_stats_list_foreach,
+	e_stats_d_list_push,
+	e_stats_d_list_pop,
+	e_stats_d_list_foreach,
+	e_stats_bp_tree_add,
+	e_stats_bp_tree_remove,
+	e_stats_bp_tree_exist,
+	e_stats_bp_tree_foreach,
+	e_stats_rb_map_add,
+	e_stats_rb_map_remove,
+	e_stats_rb_map_exist,
+	e_stats_rb_map_foreach,
+	e_stats_skip_map_add,
+	e_stats_skip_map_remove,
+	e_stats_skip_map_exist,
+	e_stats_skip_map_foreach,
+	e_stats_rb_compact_add,
+	e_stats_rb_compact_remove,
+	e_stats_rb_compact_exist,
+	e_stats_rb_compact_foreach,
+	e_stats_indexed_queue_push,
+	e_stats_indexed_queue_pop,
+	e_stats_minmax_queue_push,
+	e_stats_minmax_queue_pop,
+	e_stats_pairing_queue_push,
+	e_stats_pairing_queue_pop,
+	e_stats_radix_queue_push,
+	e_stats_radix_queue_pop,
+	e_stats_multi_queue_push,
+	e_stats_multi_queue_pop,
+	e_stats_op_max
+};
+
+/**
+ * @brief Check if the library has been built with the instrumentation
+ * @return 1 if the latencies are recorded, 0 otherwise
+ */
+export uint8_t s_stats_enabled(void);
+
+/**
+ * @brief Get a printable name of an operation
+ * @param op[in] : operation
+ * @return a valid string on success, NULL on error
+ */
+export const char *s_stats_name(enum e_stats_op op);
+
+/**
+ * @brief Merge the latencies recorded by all the threads for an operation
+ * @param op[in] : operation to investigate
+ * @return a new histogram to delete with s_histogram_delete(), NULL on error
+ * or if the instrumentation is disabled
+ */
+export struct s_histogram *s_stats_snapshot(enum e_stats_op op);
+
+/**
+ * @brief Clear the latencies recorded for all the operations
+ */
+export void s_stats_reset(void);
+
+#endif /* !_TOOLS_INCLUDE_STATS_S_STATS_H_ */
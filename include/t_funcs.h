@@ -41,6 +41,15 @@ typedef void *(*t_copy_func)(void *data);
  */
 typedef int (*t_foreach_func)(void *data, void *user_data);
 
+/**
+ * @brief Specifies the type of functions passed threw the *_foreach()
+ * function of the maps
+ * @param key[in] : the entry's key
+ * @param value[in] : the entry's value
+ * @param user_data[in] : additional data
+ */
+typedef int (*t_map_foreach_func)(void *key, void *value, void *user_data);
+
 /**
  * @brief Compare two user value
  * @param src[in] : source
@@ -49,4 +58,11 @@ typedef int (*t_foreach_func)(void *data, void *user_data);
  */
 typedef int (*t_compare_func)(void *src, void *dst);
 
+/**
+ * @brief Specifies the type of function run by an executor
+ * @param data[in] : the task's data
+ * @return 0 on success, errno on error
+ */
+typedef int (*t_task_func)(void *data);
+
 #endif /* !_TOOLS_INCLUDE_T_FUNCS_H_ */
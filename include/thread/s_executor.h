@@ -0,0 +1,102 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_THREAD_S_EXECUTOR_H_
+# define _TOOLS_INCLUDE_THREAD_S_EXECUTOR_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The executor structure (opaque). Each worker owns a work-stealing
+ * deque; idle workers steal from randomly chosen victims.
+ */
+export struct s_executor;
+
+/**
+ * @brief The wait group structure (opaque), used to join a set of tasks
+ */
+export struct s_wait_group;
+
+/**
+ * @brief Allocate a new executor instance and start its workers
+ * @param workers[in] : number of worker threads, 0 to use one per online cpu
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_executor *s_executor_new(uint32_t workers);
+
+/**
+ * @brief Shutdown an executor instance. All the tasks already submitted are
+ * run before the workers are joined.
+ * @param executor[in] : executor to delete
+ * @note no task should be submitted from outside the executor after that call,
+ * and a worker of the executor can not delete it
+ */
+export void s_executor_delete(struct s_executor *executor);
+
+/**
+ * @brief Get the number of workers of an executor
+ * @param executor[in] : executor to investigate
+ * @return a number of workers on success, 0 on error
+ */
+export uint32_t s_executor_workers(const struct s_executor *executor);
+
+/**
+ * @brief Submit a task to the executor. Can be called from any thread.
+ * @param executor[in] : executor to use
+ * @param func[in] : task function
+ * @param data[in] : data pass through the task function
+ * @return 0 on success, -errno on error
+ */
+export int s_executor_submit(struct s_executor *executor, t_task_func func,
+	void *data);
+
+/**
+ * @brief Submit a task to the executor and attach it to a wait group
+ * @param executor[in] : executor to use
+ * @param group[in] : wait group to attach the task
+ * @param func[in] : task function
+ * @param data[in] : data pass through the task function
+ * @return 0 on success, -errno on error
+ */
+export int s_executor_spawn(struct s_executor *executor,
+	struct s_wait_group *group, t_task_func func, void *data);
+
+/**
+ * @brief Wait for all the tasks attached to a wait group. When called from a
+ * worker, the caller run other tasks while waiting instead of blocking.
+ * @param executor[in] : executor running the tasks
+ * @param group[in] : wait group to join
+ * @return the bitwise or of all the task results, -errno on error
+ */
+export int s_executor_wait(struct s_executor *executor,
+	struct s_wait_group *group);
+
+/**
+ * @brief Allocate a new wait group instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_wait_group *s_wait_group_new(void);
+
+/**
+ * @brief Deallocate a wait group instance
+ * @param group[in] : wait group to delete
+ * @note the group must be joined with s_executor_wait() first
+ */
+export void s_wait_group_delete(struct s_wait_group *group);
+
+#endif /* !_TOOLS_INCLUDE_THREAD_S_EXECUTOR_H_ */
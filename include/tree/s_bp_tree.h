@@ -0,0 +1,135 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_TREE_S_BP_TREE_H_
+# define _TOOLS_INCLUDE_TREE_S_BP_TREE_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The B+tree structure (opaque). The nodes are 256 bytes wide and
+ * aligned on cache lines: an inner node holds 16 children, a leaf up to 29
+ * elements. The leaves are linked in order so the scans are sequential.
+ */
+export struct s_bp_tree;
+
+/**
+ * @brief Allocate a new B+tree instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_bp_tree *s_bp_tree_new(void);
+
+/**
+ * @brief Deallocate a B+tree instance
+ * @param tree[in] : instance to delete
+ * @note that function only delete the container, not the user pointer.
+ * To do that, use s_bp_tree_delete_full() instead
+ */
+export void s_bp_tree_delete(struct s_bp_tree *tree);
+
+/**
+ * @brief Deallocate a B+tree instance and the user pointer too
+ * @param tree[in] : instance to delete
+ * @param destroy[in] : destroy callback
+ */
+export void s_bp_tree_delete_full(struct s_bp_tree *tree,
+	t_destroy_func destroy);
+
+/**
+ * @brief Get the number of elements of the tree
+ * @param tree[in] : tree to investigate
+ * @return the number of elements
+ */
+export uint32_t s_bp_tree_size(const struct s_bp_tree *tree);
+
+/**
+ * @brief Add an element into a tree, after the elements equal to it
+ * @param tree[in] : tree to modify
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to push into the tree
+ * @return 0 on success, -errno on error
+ */
+export int s_bp_tree_add(struct s_bp_tree *tree, t_compare_func compare,
+	void *data);
+
+/**
+ * @brief Remove an element from a tree
+ * @param tree[in] : tree to modify
+ * @param compare[in] : compare element function
+ * @param destroy[in] : destroy element function (may be NULL)
+ * @param data[in] : data to remove
+ * @return 0 on success, -EAGAIN if not found, -errno on error
+ */
+export int s_bp_tree_remove(struct s_bp_tree *tree, t_compare_func compare,
+	t_destroy_func destroy, void *data);
+
+/**
+ * @brief Get the element of the tree equal to data
+ * @param tree[in] : tree to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return the element stored on success, NULL if not found
+ */
+export void *s_bp_tree_find(struct s_bp_tree *tree, t_compare_func compare,
+	void *data);
+
+/**
+ * @brief Check if an element is into the tree
+ * @param tree[in] : tree to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return 0 if found, -EAGAIN if not found, -errno on error
+ */
+export int s_bp_tree_exist(struct s_bp_tree *tree, t_compare_func compare,
+	void *data);
+
+/**
+ * @brief Get the first element not smaller than data
+ * @param tree[in] : tree to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to look for
+ * @return the element stored, NULL if all elements are smaller than data
+ */
+export void *s_bp_tree_lower_bound(struct s_bp_tree *tree,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Browse in order the entire tree
+ * @param tree[in] : instance to browse
+ * @param foreach[in] : user callback for each element
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_bp_tree_foreach(struct s_bp_tree *tree, t_foreach_func foreach,
+	void *user_data);
+
+/**
+ * @brief Browse in order the elements between two data (both included)
+ * @param tree[in] : instance to browse
+ * @param compare[in] : compare element function
+ * @param lo[in] : lower bound of the range
+ * @param hi[in] : upper bound of the range
+ * @param foreach[in] : user callback for each element
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_bp_tree_foreach_range(struct s_bp_tree *tree,
+	t_compare_func compare, void *lo, void *hi, t_foreach_func foreach,
+	void *user_data);
+
+#endif /* !_TOOLS_INCLUDE_TREE_S_BP_TREE_H_ */
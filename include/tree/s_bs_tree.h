@@ -95,6 +95,8 @@ export void *s_bs_tree_nth_biggest(struct s_bs_tree *tree, uint32_t nth);
  * @param foreach[in] : user callback for each node
  * @param data[in] : user data pass through the callback
  * @return 0 on success, errno on error
+ * @note the depth-first browses relink the tree for the time of the call,
+ * the tree must not be browsed from another thread nor from the callback
  */
 export int s_bs_tree_foreach(struct s_bs_tree *tree, enum e_tree_browse type,
 	t_foreach_func foreach, void *data);
@@ -0,0 +1,122 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_TREE_S_RB_COMPACT_H_
+# define _TOOLS_INCLUDE_TREE_S_RB_COMPACT_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief A compact red/black tree (opaque) for memory bound indexes. The
+ * nodes live in one pool and are linked by 32-bit indices, the color being
+ * the low bit of the parent index: a node takes 24 bytes instead of the 40
+ * of a s_rb_tree node, without any per-node malloc header. The nodes do not
+ * keep a subtree size and are never handed out, so there is no rank query,
+ * split or join. A tree holds up to 2^31 - 1 elements.
+ */
+export struct s_rb_compact;
+
+/**
+ * @brief Allocate a new compact tree instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_rb_compact *s_rb_compact_new(void);
+
+/**
+ * @brief Deallocate a compact tree instance
+ * @param tree[in] : instance to delete
+ * @note that function only delete the container, not the user data.
+ * To do that, use s_rb_compact_delete_full() instead
+ */
+export void s_rb_compact_delete(struct s_rb_compact *tree);
+
+/**
+ * @brief Deallocate a compact tree instance and its user data
+ * @param tree[in] : instance to delete
+ * @param destroy[in] : destroy function of the user data
+ */
+export void s_rb_compact_delete_full(struct s_rb_compact *tree,
+	t_destroy_func destroy);
+
+/**
+ * @brief Grow the pool so that a number of elements fit without moving it
+ * @param tree[in] : tree to modify
+ * @param size[in] : number of elements
+ * @return 0 on success, -errno on error
+ */
+export int s_rb_compact_reserve(struct s_rb_compact *tree, uint32_t size);
+
+/**
+ * @brief Add an element into a tree by following the binary search tree rule
+ * @param tree[in] : tree to modify
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to add
+ * @return 0 on success, -errno on error
+ */
+export int s_rb_compact_add(struct s_rb_compact *tree, t_compare_func compare,
+	void *data);
+
+/**
+ * @brief Remove an element from a tree
+ * @param tree[in] : tree to modify
+ * @param compare[in] : function to compare element
+ * @param destroy[in] : destroy function of the element removed (may be NULL)
+ * @param data[in] : data to remove
+ * @return 0 on success, -EAGAIN if not found, -errno on error
+ */
+export int s_rb_compact_remove(struct s_rb_compact *tree,
+	t_compare_func compare, t_destroy_func destroy, void *data);
+
+/**
+ * @brief Get the element stored equal to a data
+ * @param tree[in] : tree to browse
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to look for
+ * @return the element stored, NULL if not found
+ */
+export void *s_rb_compact_get(struct s_rb_compact *tree,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Check if an element is into the tree
+ * @param tree[in] : tree to browse
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to look for
+ * @return 0 if found, -EAGAIN if not found, -errno on error
+ */
+export int s_rb_compact_exist(struct s_rb_compact *tree,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Get the number of elements of the tree in O(1)
+ * @param tree[in] : tree to investigate
+ * @return the number of elements
+ */
+export uint32_t s_rb_compact_size(const struct s_rb_compact *tree);
+
+/**
+ * @brief Browse the elements of the tree in order
+ * @param tree[in] : instance to browse
+ * @param foreach[in] : user callback for each element
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_rb_compact_foreach(struct s_rb_compact *tree,
+	t_foreach_func foreach, void *user_data);
+
+#endif /* !_TOOLS_INCLUDE_TREE_S_RB_COMPACT_H_ */
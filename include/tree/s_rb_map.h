@@ -0,0 +1,129 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_TREE_S_RB_MAP_H_
+# define _TOOLS_INCLUDE_TREE_S_RB_MAP_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief The key/value map structure (opaque), ordered by key. Each entry is
+ * a single red/black tree node holding both the key and the value, the
+ * compare function is only called on keys.
+ */
+export struct s_rb_map;
+
+/**
+ * @brief Allocate a new map instance
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_rb_map *s_rb_map_new(void);
+
+/**
+ * @brief Deallocate a map instance
+ * @param map[in] : instance to delete
+ * @note that function only delete the container, not the keys and values.
+ * To do that, use s_rb_map_delete_full() instead
+ */
+export void s_rb_map_delete(struct s_rb_map *map);
+
+/**
+ * @brief Deallocate a map instance, its keys and its values
+ * @param map[in] : instance to delete
+ * @param key_destroy[in] : destroy function of the keys (may be NULL)
+ * @param value_destroy[in] : destroy function of the values (may be NULL)
+ */
+export void s_rb_map_delete_full(struct s_rb_map *map,
+	t_destroy_func key_destroy, t_destroy_func value_destroy);
+
+/**
+ * @brief Get the number of entries of the map
+ * @param map[in] : map to investigate
+ * @return the number of entries
+ */
+export uint32_t s_rb_map_size(const struct s_rb_map *map);
+
+/**
+ * @brief Get the value of a key
+ * @param map[in] : map to browse
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @return the value, NULL if not found
+ */
+export void *s_rb_map_get(struct s_rb_map *map, t_compare_func compare,
+	void *key);
+
+/**
+ * @brief Check if a key is into the map
+ * @param map[in] : map to browse
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @return 0 if found, -EAGAIN if not found, -errno on error
+ */
+export int s_rb_map_exist(struct s_rb_map *map, t_compare_func compare,
+	void *key);
+
+/**
+ * @brief Set the value of a key, adding the entry if needed. The key already
+ * stored is kept when the entry exists.
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key of the entry
+ * @param value[in] : new value
+ * @return the previous value, NULL if the entry has been added
+ */
+export void *s_rb_map_put(struct s_rb_map *map, t_compare_func compare,
+	void *key, void *value);
+
+/**
+ * @brief Get the value slot of a key, adding the entry with a value if
+ * needed, in a single descent. The slot can be read (previous value) and
+ * written in place until the entry is removed.
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key[in] : key of the entry, stored only if the entry is added
+ * @param value[in] : value of the entry if added
+ * @param added[out] : 1 if the entry has been added, 0 otherwise (may be
+ * NULL)
+ * @return the address of the value on success, NULL on error
+ */
+export void **s_rb_map_upsert(struct s_rb_map *map, t_compare_func compare,
+	void *key, void *value, uint8_t *added);
+
+/**
+ * @brief Remove the entry of a key
+ * @param map[in] : map to modify
+ * @param compare[in] : function to compare keys
+ * @param key_destroy[in] : destroy function of the key stored (may be NULL)
+ * @param key[in] : key to remove
+ * @return the value of the entry removed, NULL if not found
+ */
+export void *s_rb_map_remove(struct s_rb_map *map, t_compare_func compare,
+	t_destroy_func key_destroy, void *key);
+
+/**
+ * @brief Browse the entries of the map in key order
+ * @param map[in] : instance to browse
+ * @param foreach[in] : user callback for each entry
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_rb_map_foreach(struct s_rb_map *map, t_map_foreach_func foreach,
+	void *user_data);
+
+#endif /* !_TOOLS_INCLUDE_TREE_S_RB_MAP_H_ */
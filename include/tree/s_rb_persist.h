@@ -0,0 +1,145 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_INCLUDE_TREE_S_RB_PERSIST_H_
+# define _TOOLS_INCLUDE_TREE_S_RB_PERSIST_H_
+
+# include <stdint.h>
+# include "m_export.h"
+# include "t_funcs.h"
+
+/**
+ * @brief A version of a persistent red/black tree (opaque), NULL being the
+ * empty version. A version is a set: an element is stored at most once. A
+ * version never changes: adding or removing an element copies the O(log n)
+ * nodes of the path and gives a new version sharing all the other nodes with
+ * the old one. The nodes are reference counted, any version can be read by
+ * any number of threads without synchronization and released from any
+ * thread.
+ * @note the user data are shared between the versions and never destroyed
+ * by the tree
+ */
+export struct s_rb_persist;
+
+/**
+ * @brief A slot publishing the current version of a tree to the readers
+ * (opaque). One writer at a time publishes new versions, the readers get a
+ * reference on the current one without lock.
+ */
+export struct s_rb_snapshot;
+
+/**
+ * @brief Get a new reference on a version
+ * @param version[in] : version to acquire (may be NULL)
+ * @return version
+ */
+export struct s_rb_persist *s_rb_persist_acquire(struct s_rb_persist *version);
+
+/**
+ * @brief Drop a reference on a version, the nodes not used by another
+ * version anymore are released
+ * @param version[in] : version to release (may be NULL)
+ */
+export void s_rb_persist_release(struct s_rb_persist *version);
+
+/**
+ * @brief Get a new version with one more element
+ * @param version[in] : base version, unchanged (may be NULL)
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to add
+ * @return the new version (a new reference on the base one if an equal
+ * element is already stored), to release
+ */
+export struct s_rb_persist *s_rb_persist_add(struct s_rb_persist *version,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Get a new version without an element
+ * @param version[in] : base version, unchanged (may be NULL)
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to remove
+ * @return the new version (a new reference on the base one if data is not
+ * found), to release
+ */
+export struct s_rb_persist *s_rb_persist_remove(struct s_rb_persist *version,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Get the number of elements of a version in O(1)
+ * @param version[in] : version to investigate
+ * @return the number of elements
+ */
+export uint32_t s_rb_persist_size(const struct s_rb_persist *version);
+
+/**
+ * @brief Get the element of a version equal to data
+ * @param version[in] : version to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return the element stored on success, NULL if not found
+ */
+export void *s_rb_persist_find(const struct s_rb_persist *version,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Check if an element is into a version
+ * @param version[in] : version to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return 0 if found, -EAGAIN if not found, -errno on error
+ */
+export int s_rb_persist_exist(const struct s_rb_persist *version,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Browse in order the elements of a version
+ * @param version[in] : version to browse
+ * @param foreach[in] : user callback for each element
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_rb_persist_foreach(const struct s_rb_persist *version,
+	t_foreach_func foreach, void *user_data);
+
+/**
+ * @brief Allocate a new snapshot slot holding the empty version
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_rb_snapshot *s_rb_snapshot_new(void);
+
+/**
+ * @brief Deallocate a snapshot slot and release the version it holds
+ * @param snapshot[in] : instance to delete
+ */
+export void s_rb_snapshot_delete(struct s_rb_snapshot *snapshot);
+
+/**
+ * @brief Get a reference on the current version (readers)
+ * @param snapshot[in] : slot to read
+ * @return the current version, to release
+ */
+export struct s_rb_persist *s_rb_snapshot_get(struct s_rb_snapshot *snapshot);
+
+/**
+ * @brief Publish a new version (one writer at a time). The previous version
+ * is released once no reader can be taking a reference on it anymore.
+ * @param snapshot[in] : slot to modify
+ * @param version[in] : version to publish, the reference is taken over
+ */
+export void s_rb_snapshot_set(struct s_rb_snapshot *snapshot,
+	struct s_rb_persist *version);
+
+#endif /* !_TOOLS_INCLUDE_TREE_S_RB_PERSIST_H_ */
@@ -20,13 +20,36 @@
 # include <stdint.h>
 # include "e_tree.h"
 # include "m_export.h"
+# include "list/s_list.h"
+# include "thread/s_executor.h"
 # include "t_funcs.h"
 
 /**
- * @brief Binary search tree structure (opaque)
+ * @brief Binary search tree structure (opaque). A tree is handled through its
+ * root node; every node is also a handle on one element, valid until that
+ * element is removed (the nodes never exchange their data).
  */
 export struct s_rb_tree;
 
+/**
+ * @brief Build a balanced red/black tree from sorted elements in O(n), all
+ * the nodes are allocated in one block
+ * @param data[in] : elements sorted according to the compare function used
+ * later on the tree
+ * @param size[in] : number of elements
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_new_from_array(void **data, uint32_t size);
+
+/**
+ * @brief Build a balanced red/black tree from a sorted list in O(n), all the
+ * nodes are allocated in one block
+ * @param list[in] : elements sorted according to the compare function used
+ * later on the tree
+ * @return a valid pointer on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_new_from_list(struct s_list *list);
+
 /**
  * @brief Deallocate a red/black tree instance
  * @param tree[in] : instance to delete
@@ -52,6 +75,30 @@ export void s_rb_tree_delete_full(struct s_rb_tree *tree,
 export struct s_rb_tree *s_rb_tree_add(struct s_rb_tree *tree,
 	t_compare_func compare, void *data);
 
+/**
+ * @brief Add an element into a tree and get its node
+ * @param tree[in] : root of the tree to modify, updated
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to push into the tree
+ * @return the node holding data on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_add_node(struct s_rb_tree **tree,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Add an element into a tree, searching its place from a node close to
+ * it (finger search) instead of from the root. With the node of the previous
+ * insertion as hint, a sorted or clustered stream needs O(1) comparisons per
+ * element; the subtree sizes are still updated up to the root.
+ * @param tree[in] : root of the tree to modify, updated
+ * @param hint[in] : any node of the tree, NULL to start from the root
+ * @param compare[in] : function to compare element
+ * @param data[in] : data to push into the tree
+ * @return the node holding data on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_add_hint(struct s_rb_tree **tree,
+	struct s_rb_tree *hint, t_compare_func compare, void *data);
+
 /**
  * @brief Remove an element into a tree by following the binary search tree rule
  * @param tree[in] : tree to modify
@@ -64,30 +111,266 @@ export struct s_rb_tree *s_rb_tree_remove(struct s_rb_tree *tree,
 	t_compare_func compare, t_destroy_func destroy, void *data);
 
 /**
- * @brief Get the nth smaller element from the tree
+ * @brief Remove a node from a tree without any comparison. The rebalancing
+ * is amortized O(1), the subtree sizes of the ancestors are updated in
+ * O(log n).
+ * @param tree[in] : root of the tree to modify, updated
+ * @param node[in] : node to remove
+ * @param destroy[in] : destroy element function
+ * @return 0 on success, -errno on error
+ */
+export int s_rb_tree_remove_node(struct s_rb_tree **tree,
+	struct s_rb_tree *node, t_destroy_func destroy);
+
+/**
+ * @brief Remove all the elements between two data (both included) in
+ * O(log n) plus the release of the elements removed
+ * @param tree[in] : root of the tree to modify, updated
+ * @param cmp[in] : compare element function
+ * @param lo[in] : lower bound of the range
+ * @param hi[in] : upper bound of the range
+ * @param destroy[in] : destroy element function
+ * @return the number of elements removed on success, -errno on error
+ */
+export int s_rb_tree_remove_range(struct s_rb_tree **tree, t_compare_func cmp,
+	void *lo, void *hi, t_destroy_func destroy);
+
+/**
+ * @brief Split a tree in two in O(log n)
+ * @param tree[in] : root of the tree to split, updated with the elements
+ * smaller than data
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to split on
+ * @param right[out] : root of the tree of the elements not smaller than data
+ * @return 0 on success, -errno on error
+ */
+export int s_rb_tree_split(struct s_rb_tree **tree, t_compare_func cmp,
+	void *data, struct s_rb_tree **right);
+
+/**
+ * @brief Concatenate two trees in O(log n)
+ * @param left[in] : tree of the first elements, consumed
+ * @param right[in] : tree of the last elements (none smaller than an element
+ * of left), consumed
+ * @return the root of the tree, NULL if both are empty
+ */
+export struct s_rb_tree *s_rb_tree_join(struct s_rb_tree *left,
+	struct s_rb_tree *right);
+
+/**
+ * @brief Merge two trees used as sets (no duplicates) with
+ * O(m log(n / m + 1)) comparisons, m being the size of other. The
+ * recursion on each half runs on the executor when it is big enough.
+ * @param tree[in] : tree to merge into, consumed
+ * @param other[in] : tree to merge, consumed
+ * @param cmp[in] : compare element function
+ * @param destroy[in] : destroy function for the elements of other already
+ * into tree (may be NULL)
+ * @param executor[in] : executor to run the recursion in parallel (may be
+ * NULL)
+ * @return the root of the union
+ * @note with an executor, destroy may be called from its workers
+ */
+export struct s_rb_tree *s_rb_tree_union(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor);
+
+/**
+ * @brief Keep only the elements of a tree also into another one, both used
+ * as sets, with O(m log(n / m + 1)) comparisons
+ * @param tree[in] : tree to filter, consumed
+ * @param other[in] : tree to look into, unchanged
+ * @param cmp[in] : compare element function
+ * @param destroy[in] : destroy function for the elements removed (may be
+ * NULL)
+ * @param executor[in] : executor to run the recursion in parallel (may be
+ * NULL)
+ * @return the root of the intersection
+ */
+export struct s_rb_tree *s_rb_tree_intersection(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor);
+
+/**
+ * @brief Remove from a tree the elements into another one, both used as
+ * sets, with O(m log(n / m + 1)) comparisons
+ * @param tree[in] : tree to filter, consumed
+ * @param other[in] : tree of the elements to remove, unchanged
+ * @param cmp[in] : compare element function
+ * @param destroy[in] : destroy function for the elements removed (may be
+ * NULL)
+ * @param executor[in] : executor to run the recursion in parallel (may be
+ * NULL)
+ * @return the root of the difference
+ */
+export struct s_rb_tree *s_rb_tree_difference(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor);
+
+/**
+ * @brief Find the node holding an element
  * @param tree[in] : tree to browse
- * @param nth[in] : the nth smaller element
- * @return a valid pointer on success, NULL on error
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return a valid node on success, NULL if not found
+ */
+export struct s_rb_tree *s_rb_tree_find(struct s_rb_tree *tree,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Find the node holding an element, searching from a node close to it.
+ * The cost is O(log d) where d is the distance between hint and data.
+ * @param hint[in] : any node of the tree
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return a valid node on success, NULL if not found
+ */
+export struct s_rb_tree *s_rb_tree_find_hint(struct s_rb_tree *hint,
+	t_compare_func compare, void *data);
+
+/**
+ * @brief Get the element of a node
+ * @param node[in] : node to investigate
+ * @return the user data
+ */
+export void *s_rb_tree_data(const struct s_rb_tree *node);
+
+/**
+ * @brief Get the node of the smallest element
+ * @param tree[in] : tree to browse
+ * @return a valid node on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_first(struct s_rb_tree *tree);
+
+/**
+ * @brief Get the node of the biggest element
+ * @param tree[in] : tree to browse
+ * @return a valid node on success, NULL on error
+ */
+export struct s_rb_tree *s_rb_tree_last(struct s_rb_tree *tree);
+
+/**
+ * @brief Get the node of the next element, in O(1) amortized
+ * @param node[in] : current node
+ * @return a valid node, NULL at the end of the tree
+ */
+export struct s_rb_tree *s_rb_tree_next(struct s_rb_tree *node);
+
+/**
+ * @brief Get the node of the previous element, in O(1) amortized
+ * @param node[in] : current node
+ * @return a valid node, NULL at the beginning of the tree
+ */
+export struct s_rb_tree *s_rb_tree_prev(struct s_rb_tree *node);
+
+/**
+ * @brief Check if an element is into the tree
+ * @param tree[in] : tree to browse
+ * @param compare[in] : compare element function
+ * @param data[in] : data to find
+ * @return 0 if found, -EAGAIN if not found, -errno on error
  */
 export int s_rb_tree_exist(struct s_rb_tree *tree, t_compare_func compare,
 	void *data);
 
 /**
- * @brief Get the nth smaller element from the tree
+ * @brief Get the number of elements of the tree in O(1)
+ * @param tree[in] : tree to investigate
+ * @return the number of elements
+ */
+export uint32_t s_rb_tree_size(struct s_rb_tree *tree);
+
+/**
+ * @brief Get the nth smaller element from the tree in O(log n)
  * @param tree[in] : tree to browse
- * @param nth[in] : the nth smaller element
+ * @param nth[in] : the nth smaller element (starting at 1)
  * @return a valid pointer on success, NULL on error
  */
 export void *s_rb_tree_nth_smallest(struct s_rb_tree *tree, uint32_t nth);
 
 /**
- * @brief Get the nth smaller element from the tree
+ * @brief Get the nth bigger element from the tree in O(log n)
  * @param tree[in] : tree to browse
- * @param nth[in] : the nth smaller element
+ * @param nth[in] : the nth bigger element (starting at 1)
  * @return a valid pointer on success, NULL on error
  */
 export void *s_rb_tree_nth_biggest(struct s_rb_tree *tree, uint32_t nth);
 
+/**
+ * @brief Get the number of elements smaller than a data in O(log n). The
+ * first element not smaller than data is s_rb_tree_nth_smallest(rank + 1).
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to rank
+ * @return the number of elements smaller than data
+ */
+export uint32_t s_rb_tree_rank(struct s_rb_tree *tree, t_compare_func cmp,
+	void *data);
+
+/**
+ * @brief Get the number of elements between two data (both included) in
+ * O(log n)
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param lo[in] : lower bound of the range
+ * @param hi[in] : upper bound of the range
+ * @return the number of elements in [lo, hi]
+ */
+export uint32_t s_rb_tree_count_range(struct s_rb_tree *tree,
+	t_compare_func cmp, void *lo, void *hi);
+
+/**
+ * @brief Get the node of the first element not smaller than data
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to look for
+ * @return a valid node, NULL if all elements are smaller than data
+ */
+export struct s_rb_tree *s_rb_tree_lower_bound(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data);
+
+/**
+ * @brief Get the node of the first element bigger than data
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to look for
+ * @return a valid node, NULL if no element is bigger than data
+ */
+export struct s_rb_tree *s_rb_tree_upper_bound(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data);
+
+/**
+ * @brief Get the node of the last element not bigger than data
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to look for
+ * @return a valid node, NULL if all elements are bigger than data
+ */
+export struct s_rb_tree *s_rb_tree_floor(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data);
+
+/**
+ * @brief Convenient macro to get the node of the smallest element not smaller
+ * than data
+ */
+# define s_rb_tree_ceiling(tree, cmp, data) \
+	s_rb_tree_lower_bound(tree, cmp, data)
+
+/**
+ * @brief Browse in order the elements between two data (both included), in
+ * O(log n + k) for k elements visited. To iterate by hand, start from
+ * s_rb_tree_lower_bound() and follow s_rb_tree_next().
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param lo[in] : lower bound of the range
+ * @param hi[in] : upper bound of the range
+ * @param foreach[in] : user callback for each element
+ * @param user_data[in] : user data pass through the callback
+ * @return 0 on success, errno on error
+ */
+export int s_rb_tree_foreach_range(struct s_rb_tree *tree, t_compare_func cmp,
+	void *lo, void *hi, t_foreach_func foreach, void *user_data);
+
 /**
  * @brief Convenient macro to get the biggest element into the tree
  * @param tree[in] : tree to browse
@@ -15,6 +15,7 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include "list/s_d_list.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -57,6 +58,7 @@ void s_d_list_delete_full(struct s_d_list *list, t_destroy_func func)
 
 struct s_d_list *s_d_list_append(struct s_d_list *list, void *data)
 {
+	m_stats_scope(e_stats_d_list_push);
 	struct s_d_list *last = NULL, *new_list = _s_d_list_new(NULL, data,
 		NULL);
 
@@ -73,6 +75,7 @@ struct s_d_list *s_d_list_append(struct s_d_list *list, void *data)
 
 struct s_d_list *s_d_list_prepend(struct s_d_list *list, void *data)
 {
+	m_stats_scope(e_stats_d_list_push);
 	struct s_d_list *new_list = _s_d_list_new(NULL, data, list);
 
 	if (list) {
@@ -130,6 +133,7 @@ struct s_d_list *s_d_list_remove_element(struct s_d_list *list,
 
 struct s_d_list *s_d_list_remove(struct s_d_list *list, void *data)
 {
+	m_stats_scope(e_stats_d_list_pop);
 	struct s_d_list *tmp = list;
 
 	while (tmp) {
@@ -239,6 +243,7 @@ struct s_d_list *s_d_list_find(struct s_d_list *list, void *data)
 void s_d_list_foreach(struct s_d_list *list, t_foreach_func func,
 	void *user_data)
 {
+	m_stats_scope(e_stats_d_list_foreach);
 	while (list) {
 		struct s_d_list *next = list->next;
 		(*func)(list->data, user_data);
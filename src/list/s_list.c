@@ -15,6 +15,7 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include "list/s_list.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -55,6 +56,7 @@ void s_list_delete_full(struct s_list *list, t_destroy_func func)
 
 struct s_list *s_list_append(struct s_list *list, void *data)
 {
+	m_stats_scope(e_stats_list_push);
 	struct s_list *last = NULL, *new_list = _s_list_new(data, NULL);
 
 	if (list) {
@@ -68,6 +70,7 @@ struct s_list *s_list_append(struct s_list *list, void *data)
 
 struct s_list *s_list_prepend(struct s_list *list, void *data)
 {
+	m_stats_scope(e_stats_list_push);
 	return _s_list_new(data, list);
 }
 
@@ -110,6 +113,7 @@ struct s_list *s_list_remove_element(struct s_list *list,
 
 struct s_list *s_list_remove(struct s_list *list, void *data)
 {
+	m_stats_scope(e_stats_list_pop);
 	struct s_list *tmp = list;
 
 	while (tmp) {
@@ -209,6 +213,7 @@ struct s_list *s_list_find(struct s_list *list, void *data)
 void s_list_foreach(struct s_list *list, t_foreach_func func,
 	void *user_data)
 {
+	m_stats_scope(e_stats_list_foreach);
 	while (list) {
 		struct s_list *next = list->next;
 		(*func)(list->data, user_data);
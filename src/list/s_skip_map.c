@@ -0,0 +1,771 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <sched.h>
+#include <stdatomic.h>
+#include "list/s_skip_map.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * The map is the lazy skip list of Herlihy, Lev, Luchangco and Shavit. A node
+ * is logically removed when marked and logically added when fully linked,
+ * the searches only follow pointers. An update locks the predecessors of the
+ * entry at each of its levels, checks they still point to the expected nodes
+ * and retries its search otherwise.
+ *
+ * The nodes unlinked are retired into the limbo of the thread record of the
+ * remover, tagged with the global epoch. Every operation pins the epoch into
+ * a thread record while it runs; the epoch only moves forward once every
+ * pinned record has seen it, so a node retired at epoch e is freed once the
+ * epoch reaches e + 2.
+ */
+
+/**
+ * @brief Maximum number of levels of a node (one level in two kept)
+ */
+#define _S_SKIP_MAP_LEVELS 24
+
+/**
+ * @brief Number of nodes retired by a thread record between two attempts to
+ * move the epoch forward
+ */
+#define _S_SKIP_MAP_ADVANCE 64
+
+/**
+ * @brief A map entry
+ * @param key: user key
+ * @param value: user value, written under the node lock
+ * @param lock: held by the updates of the node and of its next pointers
+ * @param marked: 1 once the node is logically removed
+ * @param linked: 1 once the node is linked at all its levels
+ * @param levels: number of levels of the node
+ * @param limbo: next retired node
+ * @param next: next node of each level
+ */
+struct _s_skip_node {
+	void *key;
+	_Atomic(void *) value;
+	atomic_uchar lock;
+	atomic_uchar marked;
+	atomic_uchar linked;
+	uint8_t levels;
+	struct _s_skip_node *limbo;
+	_Atomic(struct _s_skip_node *) next[];
+};
+
+/**
+ * @brief A thread record, used by a single thread at a time and padded to its
+ * own cache line
+ * @param busy: 1 while a thread uses the record
+ * @param epoch: epoch pinned shifted left by one, with the low bit set while
+ * pinned
+ * @param size: number of entries added minus number removed with the record
+ * @param retired: number of nodes retired with the record
+ * @param limbo: nodes retired, per epoch modulo 3
+ * @param limbo_epoch: epoch of each limbo list
+ * @param next: next record of the map
+ */
+struct _s_skip_thread {
+	atomic_uchar busy;
+	atomic_ullong epoch;
+	atomic_llong size;
+	uint32_t retired;
+	struct _s_skip_node *limbo[3];
+	uint64_t limbo_epoch[3];
+	struct _s_skip_thread *next;
+} __attribute__((aligned(64)));
+
+/**
+ * @brief The concurrent map structure
+ * @param id: identifier of the map, never reused
+ * @param key_destroy: destroy function of the keys removed
+ * @param epoch: global epoch
+ * @param threads: thread records
+ * @param head: sentinel node, with all the levels
+ */
+struct s_skip_map {
+	uint64_t id;
+	t_destroy_func key_destroy;
+	atomic_ullong epoch;
+	_Atomic(struct _s_skip_thread *) threads;
+	struct _s_skip_node *head;
+};
+
+/**
+ * @brief Identifier of the next map allocated
+ */
+static atomic_ullong _s_skip_map_ids = 1;
+
+/**
+ * @brief Record last used by the calling thread, and the id of its map
+ */
+static __thread struct _s_skip_thread *_s_skip_hint;
+static __thread uint64_t _s_skip_hint_id;
+
+/**
+ * @brief State of the level random generator of the calling thread
+ */
+static __thread uint64_t _s_skip_seed;
+
+/**
+ * @brief Pick the number of levels of a new node (xorshift64)
+ * @return a number of levels in [1, _S_SKIP_MAP_LEVELS]
+ */
+static uint8_t _s_skip_map_levels(void)
+{
+	uint64_t x = _s_skip_seed;
+
+	if (!x)
+		x = 0x9e3779b97f4a7c15ULL * ((uintptr_t)&_s_skip_seed | 1);
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	_s_skip_seed = x;
+	return 1 + __builtin_ctzll(x | (1ULL << (_S_SKIP_MAP_LEVELS - 1)));
+}
+
+static struct _s_skip_node *_s_skip_node_new(void *key, void *value,
+	uint8_t levels)
+{
+	struct _s_skip_node *node = _malloc(sizeof(struct _s_skip_node) +
+		levels * sizeof(_Atomic(struct _s_skip_node *)));
+	node->key = key;
+	atomic_init(&node->value, value);
+	node->levels = levels;
+	return node;
+}
+
+static void _s_skip_node_lock(struct _s_skip_node *node)
+{
+	while (atomic_exchange_explicit(&node->lock, 1, memory_order_acquire))
+		sched_yield();
+}
+
+static void _s_skip_node_unlock(struct _s_skip_node *node)
+{
+	atomic_store_explicit(&node->lock, 0, memory_order_release);
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * epoch implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Take a free thread record, starting from the one used last time
+ * @param map[in] : map to use
+ * @return a record owned by the calling thread
+ */
+static struct _s_skip_thread *_s_skip_map_claim(struct s_skip_map *map)
+{
+	struct _s_skip_thread *first = atomic_load_explicit(&map->threads,
+		memory_order_acquire);
+	struct _s_skip_thread *start = (_s_skip_hint_id == map->id) ?
+		_s_skip_hint : first;
+	struct _s_skip_thread *record = start;
+
+	/* the records are never unlinked before the map is deleted */
+	while (record) {
+		if (!atomic_load_explicit(&record->busy, memory_order_relaxed) &&
+			!atomic_exchange_explicit(&record->busy, 1,
+			memory_order_acquire))
+			goto claimed;
+		record = record->next;
+		if (!record && start != first) {
+			record = first;
+			start = first;
+		}
+	}
+
+	record = _aligned_malloc(64, sizeof(struct _s_skip_thread));
+	atomic_init(&record->busy, 1);
+	atomic_init(&record->epoch, 0);
+	atomic_init(&record->size, 0);
+	record->next = atomic_load_explicit(&map->threads,
+		memory_order_relaxed);
+	while (!atomic_compare_exchange_weak_explicit(&map->threads,
+		&record->next, record, memory_order_release,
+		memory_order_relaxed));
+
+claimed:
+	_s_skip_hint = record;
+	_s_skip_hint_id = map->id;
+	return record;
+}
+
+/**
+ * @brief Claim a thread record and pin the current epoch into it. The nodes
+ * reached until _s_skip_map_exit() stay allocated.
+ * @param map[in] : map to use
+ * @return the record pinned
+ */
+static struct _s_skip_thread *_s_skip_map_enter(struct s_skip_map *map)
+{
+	struct _s_skip_thread *record = _s_skip_map_claim(map);
+	uint64_t epoch;
+
+	/* an epoch published too late would not hold back the reclamation */
+	do {
+		epoch = atomic_load(&map->epoch);
+		atomic_store(&record->epoch, (epoch << 1) | 1);
+	} while (atomic_load(&map->epoch) != epoch);
+	return record;
+}
+
+static void _s_skip_map_exit(struct _s_skip_thread *record)
+{
+	atomic_store_explicit(&record->epoch, 0, memory_order_release);
+	atomic_store_explicit(&record->busy, 0, memory_order_release);
+}
+
+/**
+ * @brief Free a list of retired nodes
+ * @param map[in] : map owning the nodes
+ * @param node[in] : first node of the list
+ */
+static void _s_skip_map_free(struct s_skip_map *map, struct _s_skip_node *node)
+{
+	while (node) {
+		struct _s_skip_node *limbo = node->limbo;
+		if (map->key_destroy)
+			map->key_destroy(node->key);
+		_free(node);
+		node = limbo;
+	}
+}
+
+/**
+ * @brief Move the epoch forward if every pinned record has seen it
+ * @param map[in] : map to use
+ */
+static void _s_skip_map_advance(struct s_skip_map *map)
+{
+	uint64_t epoch = atomic_load(&map->epoch);
+
+	for (struct _s_skip_thread *record = atomic_load(&map->threads); record;
+		record = record->next) {
+		uint64_t pinned = atomic_load(&record->epoch);
+		if ((pinned & 1) && (pinned >> 1) != epoch)
+			return;
+	}
+	atomic_compare_exchange_strong(&map->epoch, &epoch, epoch + 1);
+}
+
+/**
+ * @brief Retire a node unlinked, and free the nodes of the record retired two
+ * epochs ago or more
+ * @param map[in] : map owning the node
+ * @param record[in] : record pinned by the caller
+ * @param node[in] : node unlinked at all its levels
+ */
+static void _s_skip_map_retire(struct s_skip_map *map,
+	struct _s_skip_thread *record, struct _s_skip_node *node)
+{
+	uint64_t epoch = atomic_load(&map->epoch);
+
+	for (uint8_t i = 0; i < 3; i++) {
+		/* the list of epoch % 3 is reused only once freed */
+		if (record->limbo[i] && record->limbo_epoch[i] + 2 <= epoch) {
+			_s_skip_map_free(map, record->limbo[i]);
+			record->limbo[i] = NULL;
+		}
+	}
+	node->limbo = record->limbo[epoch % 3];
+	record->limbo[epoch % 3] = node;
+	record->limbo_epoch[epoch % 3] = epoch;
+
+	if (++record->retired % _S_SKIP_MAP_ADVANCE == 0)
+		_s_skip_map_advance(map);
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * search implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Move forward on a level up to the first node not smaller than key.
+ * The node ending the level above is often reached again, its comparison is
+ * reused.
+ * @param pred[in] : last node smaller than key, updated
+ * @param curr[in] : next node of pred, updated
+ * @param level[in] : level browsed
+ * @param bound[in] : node ending the level above (may be NULL)
+ * @param bound_ret[in] : comparison of bound with key
+ * @param cmp[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @return the comparison of curr with key, 1 if curr is NULL
+ */
+static inline int _s_skip_map_step(struct _s_skip_node **pred,
+	struct _s_skip_node **curr, int level, struct _s_skip_node *bound,
+	int bound_ret, t_compare_func cmp, void *key)
+{
+	while (*curr) {
+		int ret = (*curr == bound) ? bound_ret : cmp((*curr)->key, key);
+		if (ret >= 0)
+			return ret;
+		*pred = *curr;
+		*curr = atomic_load_explicit(&(*pred)->next[level],
+			memory_order_acquire);
+	}
+	return 1;
+}
+
+/**
+ * @brief Get the last node before key and the first node from key at each
+ * level
+ * @param map[in] : map to browse
+ * @param cmp[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @param preds[out] : last node smaller than key of each level
+ * @param succs[out] : next node of each pred
+ * @return the highest level where key has been found, -1 if not found
+ */
+static int _s_skip_map_search(struct s_skip_map *map, t_compare_func cmp,
+	void *key, struct _s_skip_node **preds, struct _s_skip_node **succs)
+{
+	struct _s_skip_node *pred = map->head;
+	struct _s_skip_node *bound = NULL;
+	int bound_ret = 1;
+	int found = -1;
+
+	for (int level = _S_SKIP_MAP_LEVELS - 1; level >= 0; level--) {
+		struct _s_skip_node *curr = atomic_load_explicit(
+			&pred->next[level], memory_order_acquire);
+		int ret = _s_skip_map_step(&pred, &curr, level, bound,
+			bound_ret, cmp, key);
+
+		if (found < 0 && curr && ret == 0)
+			found = level;
+		preds[level] = pred;
+		succs[level] = curr;
+		bound = curr;
+		bound_ret = ret;
+	}
+	return found;
+}
+
+/**
+ * @brief Get the node of a key, logically in the map or not
+ * @param map[in] : map to browse
+ * @param cmp[in] : function to compare keys
+ * @param key[in] : key to look for
+ * @param or_after[in] : 1 to get the first node from key if key is not found
+ * @return a node, NULL if not found
+ */
+static struct _s_skip_node *_s_skip_map_lookup(struct s_skip_map *map,
+	t_compare_func cmp, void *key, uint8_t or_after)
+{
+	struct _s_skip_node *pred = map->head;
+	struct _s_skip_node *curr = NULL;
+	struct _s_skip_node *bound = NULL;
+
+	for (int level = _S_SKIP_MAP_LEVELS - 1; level >= 0; level--) {
+		curr = atomic_load_explicit(&pred->next[level],
+			memory_order_acquire);
+		if (curr && _s_skip_map_step(&pred, &curr, level, bound, 1, cmp,
+			key) == 0)
+			return curr;
+		bound = curr;
+	}
+	return (or_after) ? curr : NULL;
+}
+
+/**
+ * @brief Check if a node is logically into the map
+ */
+static uint8_t _s_skip_node_valid(struct _s_skip_node *node)
+{
+	return node && atomic_load_explicit(&node->linked,
+		memory_order_acquire) && !atomic_load_explicit(&node->marked,
+		memory_order_acquire);
+}
+
+struct s_skip_map *s_skip_map_new(t_destroy_func key_destroy)
+{
+	struct s_skip_map *map = _malloc(sizeof(struct s_skip_map));
+	map->id = atomic_fetch_add(&_s_skip_map_ids, 1);
+	map->key_destroy = key_destroy;
+	atomic_init(&map->epoch, 0);
+	atomic_init(&map->threads, NULL);
+	map->head = _s_skip_node_new(NULL, NULL, _S_SKIP_MAP_LEVELS);
+	return map;
+}
+
+/**
+ * @brief Release all the nodes and thread records of a map
+ * @param map[in] : map to clean
+ * @param key_destroy[in] : optional delete function for the keys in the map
+ * @param value_destroy[in] : optional delete function for the values
+ */
+static void _s_skip_map_clean(struct s_skip_map *map,
+	t_destroy_func key_destroy, t_destroy_func value_destroy)
+{
+	struct _s_skip_node *node = map->head;
+
+	while (node) {
+		struct _s_skip_node *next = atomic_load(&node->next[0]);
+		if (node != map->head) {
+			if (key_destroy)
+				key_destroy(node->key);
+			if (value_destroy)
+				value_destroy(atomic_load(&node->value));
+		}
+		_free(node);
+		node = next;
+	}
+
+	struct _s_skip_thread *record = atomic_load(&map->threads);
+	while (record) {
+		struct _s_skip_thread *next = record->next;
+		for (uint8_t i = 0; i < 3; i++)
+			_s_skip_map_free(map, record->limbo[i]);
+		_free(record);
+		record = next;
+	}
+}
+
+void s_skip_map_delete(struct s_skip_map *map)
+{
+	m_return_if_fail(map);
+
+	_s_skip_map_clean(map, NULL, NULL);
+	_free(map);
+}
+
+void s_skip_map_delete_full(struct s_skip_map *map,
+	t_destroy_func value_destroy)
+{
+	m_return_if_fail(map);
+
+	_s_skip_map_clean(map, map->key_destroy, value_destroy);
+	_free(map);
+}
+
+uint32_t s_skip_map_size(struct s_skip_map *map)
+{
+	m_return_val_if_fail(map, 0);
+
+	int64_t size = 0;
+	for (struct _s_skip_thread *record = atomic_load(&map->threads); record;
+		record = record->next)
+		size += atomic_load_explicit(&record->size,
+			memory_order_relaxed);
+	return (size > 0) ? (uint32_t)size : 0;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * find implementation
+ * -----------------------------------------------------------------------------
+ */
+void *s_skip_map_get(struct s_skip_map *map, t_compare_func compare,
+	void *key)
+{
+	m_stats_scope(e_stats_skip_map_exist);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	struct _s_skip_node *node = _s_skip_map_lookup(map, compare, key, 0);
+	void *value = (_s_skip_node_valid(node)) ?
+		atomic_load_explicit(&node->value, memory_order_acquire) : NULL;
+	_s_skip_map_exit(record);
+	return value;
+}
+
+int s_skip_map_exist(struct s_skip_map *map, t_compare_func compare,
+	void *key)
+{
+	m_stats_scope(e_stats_skip_map_exist);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	struct _s_skip_node *node = _s_skip_map_lookup(map, compare, key, 0);
+	int ret = (_s_skip_node_valid(node)) ? 0 : -EAGAIN;
+	_s_skip_map_exit(record);
+	return ret;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * add implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Unlock the distinct predecessors locked from level 0 to a level
+ * @param preds[in] : predecessors
+ * @param top[in] : highest level locked, -1 if none
+ */
+static void _s_skip_map_unlock(struct _s_skip_node **preds, int top)
+{
+	struct _s_skip_node *prev = NULL;
+
+	for (int level = 0; level <= top; level++) {
+		if (preds[level] != prev)
+			_s_skip_node_unlock(preds[level]);
+		prev = preds[level];
+	}
+}
+
+/**
+ * @brief Add an entry, or update the value of the entry of key
+ * @param map[in] : map to modify
+ * @param cmp[in] : function to compare keys
+ * @param key[in] : key of the entry
+ * @param value[in] : value of the entry
+ * @param replace[in] : 1 to update the value of an existing entry
+ * @param added[out] : 1 if the entry has been added, 0 otherwise
+ * @return the value of the existing entry, NULL if added
+ */
+static void *_s_skip_map_insert(struct s_skip_map *map, t_compare_func cmp,
+	void *key, void *value, uint8_t replace, uint8_t *added)
+{
+	struct _s_skip_node *preds[_S_SKIP_MAP_LEVELS];
+	struct _s_skip_node *succs[_S_SKIP_MAP_LEVELS];
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	uint8_t levels = _s_skip_map_levels();
+	void *previous = NULL;
+
+	for (;;) {
+		int found = _s_skip_map_search(map, cmp, key, preds, succs);
+
+		if (found >= 0) {
+			struct _s_skip_node *node = succs[found];
+			if (atomic_load(&node->marked))
+				continue;
+			while (!atomic_load(&node->linked))
+				sched_yield();
+			if (!replace) {
+				previous = atomic_load(&node->value);
+				break;
+			}
+
+			/* a remover marks under the node lock, then reads value */
+			_s_skip_node_lock(node);
+			if (atomic_load(&node->marked)) {
+				_s_skip_node_unlock(node);
+				continue;
+			}
+			previous = atomic_exchange(&node->value, value);
+			_s_skip_node_unlock(node);
+			break;
+		}
+
+		/* lock the predecessors and check they still lead to succs */
+		struct _s_skip_node *prev = NULL;
+		uint8_t valid = 1;
+		int top = -1;
+		for (int level = 0; valid && level < levels; level++) {
+			struct _s_skip_node *pred = preds[level];
+			struct _s_skip_node *succ = succs[level];
+			if (pred != prev) {
+				_s_skip_node_lock(pred);
+				prev = pred;
+			}
+			top = level;
+			valid = !atomic_load(&pred->marked) &&
+				(!succ || !atomic_load(&succ->marked)) &&
+				atomic_load(&pred->next[level]) == succ;
+		}
+		if (!valid) {
+			_s_skip_map_unlock(preds, top);
+			continue;
+		}
+
+		struct _s_skip_node *node = _s_skip_node_new(key, value, levels);
+		for (int level = 0; level < levels; level++)
+			atomic_init(&node->next[level], succs[level]);
+		for (int level = 0; level < levels; level++)
+			atomic_store_explicit(&preds[level]->next[level], node,
+				memory_order_release);
+		atomic_store_explicit(&node->linked, 1, memory_order_release);
+		_s_skip_map_unlock(preds, top);
+
+		atomic_fetch_add_explicit(&record->size, 1,
+			memory_order_relaxed);
+		*added = 1;
+		break;
+	}
+	_s_skip_map_exit(record);
+	return previous;
+}
+
+void *s_skip_map_put(struct s_skip_map *map, t_compare_func compare,
+	void *key, void *value)
+{
+	m_stats_scope(e_stats_skip_map_add);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	uint8_t added = 0;
+	return _s_skip_map_insert(map, compare, key, value, 1, &added);
+}
+
+int s_skip_map_add(struct s_skip_map *map, t_compare_func compare,
+	void *key, void *value)
+{
+	m_stats_scope(e_stats_skip_map_add);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	uint8_t added = 0;
+	_s_skip_map_insert(map, compare, key, value, 0, &added);
+	return (added) ? 0 : -EEXIST;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * remove implementation
+ * -----------------------------------------------------------------------------
+ */
+void *s_skip_map_remove(struct s_skip_map *map, t_compare_func compare,
+	void *key)
+{
+	m_stats_scope(e_stats_skip_map_remove);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct _s_skip_node *preds[_S_SKIP_MAP_LEVELS];
+	struct _s_skip_node *succs[_S_SKIP_MAP_LEVELS];
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	struct _s_skip_node *victim = NULL;
+	void *value = NULL;
+
+	for (;;) {
+		int found = _s_skip_map_search(map, compare, key, preds, succs);
+
+		if (!victim) {
+			/* only a node fully linked, found at its top level */
+			if (found < 0)
+				break;
+			struct _s_skip_node *node = succs[found];
+			if (!atomic_load(&node->linked) ||
+				node->levels != found + 1 ||
+				atomic_load(&node->marked))
+				break;
+
+			_s_skip_node_lock(node);
+			if (atomic_load(&node->marked)) {
+				_s_skip_node_unlock(node);
+				break;
+			}
+			atomic_store(&node->marked, 1);
+			value = atomic_load(&node->value);
+			victim = node;
+		}
+
+		/* lock the predecessors and check they still lead to victim */
+		struct _s_skip_node *prev = NULL;
+		uint8_t valid = 1;
+		int top = -1;
+		for (int level = 0; valid && level < victim->levels; level++) {
+			struct _s_skip_node *pred = preds[level];
+			if (pred != prev) {
+				_s_skip_node_lock(pred);
+				prev = pred;
+			}
+			top = level;
+			valid = !atomic_load(&pred->marked) &&
+				atomic_load(&pred->next[level]) == victim;
+		}
+		if (!valid) {
+			_s_skip_map_unlock(preds, top);
+			continue;
+		}
+
+		for (int level = victim->levels - 1; level >= 0; level--)
+			atomic_store_explicit(&preds[level]->next[level],
+				atomic_load(&victim->next[level]),
+				memory_order_release);
+		_s_skip_node_unlock(victim);
+		_s_skip_map_unlock(preds, top);
+
+		atomic_fetch_sub_explicit(&record->size, 1,
+			memory_order_relaxed);
+		_s_skip_map_retire(map, record, victim);
+		break;
+	}
+	_s_skip_map_exit(record);
+	return value;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * foreach implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Browse level 0 from a node
+ * @param node[in] : first node to visit
+ * @param cmp[in] : function to compare keys, NULL to browse up to the end
+ * @param hi[in] : last key to visit
+ * @param foreach[in] : user callback for each entry
+ * @param user_data[in] : user data pass through the callback
+ * @return the bitwise or of the callback results
+ */
+static int _s_skip_map_walk(struct _s_skip_node *node, t_compare_func cmp,
+	void *hi, t_map_foreach_func foreach, void *user_data)
+{
+	int ret = 0;
+
+	for (; node; node = atomic_load_explicit(&node->next[0],
+		memory_order_acquire)) {
+		if (cmp && cmp(node->key, hi) > 0)
+			break;
+		if (_s_skip_node_valid(node))
+			ret |= foreach(node->key, atomic_load_explicit(
+				&node->value, memory_order_acquire), user_data);
+	}
+	return ret;
+}
+
+int s_skip_map_foreach(struct s_skip_map *map, t_map_foreach_func foreach,
+	void *user_data)
+{
+	m_stats_scope(e_stats_skip_map_foreach);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	int ret = _s_skip_map_walk(atomic_load_explicit(&map->head->next[0],
+		memory_order_acquire), NULL, NULL, foreach, user_data);
+	_s_skip_map_exit(record);
+	return ret;
+}
+
+int s_skip_map_foreach_range(struct s_skip_map *map,
+	t_compare_func compare, void *lo, void *hi, t_map_foreach_func foreach,
+	void *user_data)
+{
+	m_stats_scope(e_stats_skip_map_foreach);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	struct _s_skip_thread *record = _s_skip_map_enter(map);
+	int ret = _s_skip_map_walk(_s_skip_map_lookup(map, compare, lo, 1),
+		compare, hi, foreach, user_data);
+	_s_skip_map_exit(record);
+	return ret;
+}
@@ -16,6 +16,7 @@
  */
 #include "list/s_list.h"
 #include "list/s_stack.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -55,6 +56,7 @@ uint8_t s_stack_empty(const struct s_stack *stack)
 
 void *s_stack_pop(struct s_stack *stack)
 {
+	m_stats_scope(e_stats_stack_pop);
 	m_return_val_if_fail(stack, NULL);
 
 	if (!s_stack_empty(stack)) {
@@ -70,6 +72,7 @@ void *s_stack_pop(struct s_stack *stack)
 
 int s_stack_push(struct s_stack *stack, void *data)
 {
+	m_stats_scope(e_stats_stack_push);
 	m_return_val_if_fail(stack, -EINVAL);
 
 	stack->list = s_list_append(stack->list, data);
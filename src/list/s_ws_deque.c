@@ -0,0 +1,227 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <stdatomic.h>
+#include "list/s_ws_deque.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Initial number of slots of a deque (must be a power of 2)
+ */
+#define _S_WS_DEQUE_DEFAULT_SIZE 32
+
+/**
+ * @brief Circular array used as storage by the deque
+ * @param mask: number of slots - 1
+ * @param retired: previous (smaller) array, kept alive for the thieves
+ * @param slots: storage
+ */
+struct _s_ws_array {
+	int64_t mask;
+	struct _s_ws_array *retired;
+	_Atomic(void *) slots[];
+};
+
+/**
+ * @brief The work-stealing deque structure
+ * @param top: next index to steal, only incremented by a CAS
+ * @param bottom: next index to push, only written by the owner
+ * @param array: current storage
+ */
+struct s_ws_deque {
+	_Atomic int64_t top;
+	_Atomic int64_t bottom;
+	_Atomic(struct _s_ws_array *) array;
+};
+
+/**
+ * @brief Allocate a new circular array
+ * @param size[in] : number of slots (power of 2)
+ * @return a valid pointer
+ */
+static struct _s_ws_array *_s_ws_array_new(int64_t size)
+{
+	struct _s_ws_array *array = _malloc(sizeof(struct _s_ws_array) +
+		size * sizeof(_Atomic(void *)));
+	array->mask = size - 1;
+	return array;
+}
+
+/**
+ * @brief A convenience macro to get a slot of the array
+ */
+#define m_ws_array_get(a, i) \
+	atomic_load_explicit(&(a)->slots[(i) & (a)->mask], memory_order_relaxed)
+
+/**
+ * @brief A convenience macro to set a slot of the array
+ */
+#define m_ws_array_set(a, i, v) \
+	atomic_store_explicit(&(a)->slots[(i) & (a)->mask], v, \
+		memory_order_relaxed)
+
+/**
+ * @brief Double the storage of the deque (owner only). The old array is
+ * retired rather than released: a thief may still be reading from it.
+ * @param deque[in] : deque to grow
+ * @param a[in] : current array
+ * @param top[in] : current top index
+ * @param bottom[in] : current bottom index
+ * @return the new array
+ */
+static struct _s_ws_array *_s_ws_deque_grow(struct s_ws_deque *deque,
+	struct _s_ws_array *a, int64_t top, int64_t bottom)
+{
+	struct _s_ws_array *new = _s_ws_array_new((a->mask + 1) << 1);
+
+	for (int64_t i = top; i < bottom; i++)
+		m_ws_array_set(new, i, m_ws_array_get(a, i));
+	new->retired = a;
+	atomic_store_explicit(&deque->array, new, memory_order_release);
+	return new;
+}
+
+struct s_ws_deque *s_ws_deque_new(void)
+{
+	struct s_ws_deque *deque = _malloc(sizeof(struct s_ws_deque));
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, _s_ws_array_new(_S_WS_DEQUE_DEFAULT_SIZE));
+	return deque;
+}
+
+/**
+ * @brief Release the array chain of a deque
+ * @param deque[in] : deque to clean
+ * @param func[in] : optional delete function for the remaining user data
+ */
+static void _s_ws_deque_clean(struct s_ws_deque *deque, t_destroy_func func)
+{
+	struct _s_ws_array *a = atomic_load(&deque->array);
+
+	if (func) {
+		int64_t b = atomic_load(&deque->bottom);
+		for (int64_t t = atomic_load(&deque->top); t < b; t++)
+			func(m_ws_array_get(a, t));
+	}
+
+	while (a) {
+		struct _s_ws_array *retired = a->retired;
+		_free(a);
+		a = retired;
+	}
+}
+
+void s_ws_deque_delete(struct s_ws_deque *deque)
+{
+	m_return_if_fail(deque);
+
+	_s_ws_deque_clean(deque, NULL);
+	_free(deque);
+}
+
+void s_ws_deque_delete_full(struct s_ws_deque *deque, t_destroy_func func)
+{
+	m_return_if_fail(deque);
+	m_return_if_fail(func);
+
+	_s_ws_deque_clean(deque, func);
+	_free(deque);
+}
+
+uint8_t s_ws_deque_empty(const struct s_ws_deque *deque)
+{
+	m_return_val_if_fail(deque, 1);
+
+	int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+	return b <= t;
+}
+
+int s_ws_deque_push(struct s_ws_deque *deque, void *data)
+{
+	m_stats_scope(e_stats_ws_deque_push);
+	m_return_val_if_fail(deque, -EINVAL);
+	m_return_val_if_fail(data, -EINVAL);
+
+	int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	struct _s_ws_array *a = atomic_load_explicit(&deque->array,
+		memory_order_relaxed);
+
+	if (b - t > a->mask)
+		a = _s_ws_deque_grow(deque, a, t, b);
+
+	m_ws_array_set(a, b, data);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+	return 0;
+}
+
+void *s_ws_deque_pop(struct s_ws_deque *deque)
+{
+	m_stats_scope(e_stats_ws_deque_pop);
+	m_return_val_if_fail(deque, NULL);
+
+	int64_t b = atomic_load_explicit(&deque->bottom,
+		memory_order_relaxed) - 1;
+	struct _s_ws_array *a = atomic_load_explicit(&deque->array,
+		memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	void *data = NULL;
+	if (t <= b) {
+		data = m_ws_array_get(a, b);
+		if (t == b) {
+			/* last element: race against the thieves */
+			if (!atomic_compare_exchange_strong_explicit(&deque->top,
+					&t, t + 1, memory_order_seq_cst,
+					memory_order_relaxed))
+				data = NULL;
+			atomic_store_explicit(&deque->bottom, b + 1,
+				memory_order_relaxed);
+		}
+	} else {
+		atomic_store_explicit(&deque->bottom, b + 1,
+			memory_order_relaxed);
+	}
+	return data;
+}
+
+void *s_ws_deque_steal(struct s_ws_deque *deque)
+{
+	m_stats_scope(e_stats_ws_deque_steal);
+	m_return_val_if_fail(deque, NULL);
+
+	int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (t >= b)
+		return NULL;
+
+	struct _s_ws_array *a = atomic_load_explicit(&deque->array,
+		memory_order_acquire);
+	void *data = m_ws_array_get(a, t);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+			memory_order_seq_cst, memory_order_relaxed))
+		return NULL;
+	return data;
+}
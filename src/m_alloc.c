@@ -40,6 +40,17 @@ void *_malloc(uint32_t size)
 	return alloc;
 }
 
+void *_aligned_malloc(uint32_t align, uint32_t size)
+{
+	void *alloc = NULL;
+
+	if (posix_memalign(&alloc, align, size))
+		assert(0);
+
+	memset(alloc, 0, size);
+	return alloc;
+}
+
 void _free(void *ptr)
 {
 	m_return_if_fail(ptr);
@@ -0,0 +1,68 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_heap-private.h"
+
+void _s_heap_sift_up(void **heap, uint32_t index, uint8_t arity,
+	enum e_ordered ordering, t_compare_func cmp)
+{
+	void *data = heap[index];
+
+	/* move the parents down and write the element once */
+	while (index > 0) {
+		uint32_t parent = m_heap_parent(index, arity);
+		if (!m_heap_before(ordering, cmp, data, heap[parent]))
+			break;
+		heap[index] = heap[parent];
+		index = parent;
+	}
+	heap[index] = data;
+}
+
+void _s_heap_sift_down(void **heap, uint32_t size, uint32_t index,
+	uint8_t arity, enum e_ordered ordering, t_compare_func cmp)
+{
+	void *data = heap[index];
+
+	while (1) {
+		uint32_t child = m_heap_child(index, arity);
+		if (child >= size)
+			break;
+
+		uint32_t last = (size - child > arity) ? child + arity : size;
+		uint32_t best = child;
+		for (child++; child < last; child++)
+			if (m_heap_before(ordering, cmp, heap[child], heap[best]))
+				best = child;
+
+		if (!m_heap_before(ordering, cmp, heap[best], data))
+			break;
+		heap[index] = heap[best];
+		index = best;
+	}
+	heap[index] = data;
+}
+
+void _s_heap_make(void **heap, uint32_t size, uint8_t arity,
+	enum e_ordered ordering, t_compare_func cmp)
+{
+	if (size < 2)
+		return;
+
+	/* sift down every parent, deepest first */
+	for (uint32_t i = m_heap_parent(size - 1, arity) + 1; i-- > 0;)
+		_s_heap_sift_down(heap, size, i, arity, ordering, cmp);
+}
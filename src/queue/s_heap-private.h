@@ -0,0 +1,74 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_S_HEAP_PRIVATE_H_
+# define _TOOLS_S_HEAP_PRIVATE_H_
+
+# include <stdint.h>
+# include "queue/s_ordered_queue.h"
+# include "t_funcs.h"
+
+/**
+ * @brief A convenience macro to know if a must leave the heap before b
+ */
+# define m_heap_before(ordering, cmp, a, b) \
+	((ordering) == e_ordered_increase ? (cmp)(a, b) < 0 : (cmp)(a, b) > 0)
+
+/**
+ * @brief A convenience macro to get the parent index of an element
+ */
+# define m_heap_parent(index, arity) (((index) - 1) / (arity))
+
+/**
+ * @brief A convenience macro to get the first child index of an element
+ */
+# define m_heap_child(index, arity) ((index) * (arity) + 1)
+
+/**
+ * @brief Move an element up to its place in a d-ary heap
+ * @param heap[in] : heap storage
+ * @param index[in] : index of the element
+ * @param arity[in] : number of children per element
+ * @param ordering[in] : heap ordering
+ * @param cmp[in] : comparison operator
+ */
+void _s_heap_sift_up(void **heap, uint32_t index, uint8_t arity,
+	enum e_ordered ordering, t_compare_func cmp);
+
+/**
+ * @brief Move an element down to its place in a d-ary heap
+ * @param heap[in] : heap storage
+ * @param size[in] : number of elements in the heap
+ * @param index[in] : index of the element
+ * @param arity[in] : number of children per element
+ * @param ordering[in] : heap ordering
+ * @param cmp[in] : comparison operator
+ */
+void _s_heap_sift_down(void **heap, uint32_t size, uint32_t index,
+	uint8_t arity, enum e_ordered ordering, t_compare_func cmp);
+
+/**
+ * @brief Restore the heap property of an array in O(n) (Floyd)
+ * @param heap[in] : heap storage
+ * @param size[in] : number of elements in the heap
+ * @param arity[in] : number of children per element
+ * @param ordering[in] : heap ordering
+ * @param cmp[in] : comparison operator
+ */
+void _s_heap_make(void **heap, uint32_t size, uint8_t arity,
+	enum e_ordered ordering, t_compare_func cmp);
+
+#endif /* !_TOOLS_S_HEAP_PRIVATE_H_ */
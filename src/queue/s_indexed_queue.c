@@ -0,0 +1,352 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_indexed_queue.h"
+#include "queue/s_heap-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Number of children per heap element
+ */
+#define _S_INDEXED_QUEUE_ARITY 4
+
+/**
+ * @brief Initial number of slots of the queue
+ */
+#define _S_INDEXED_QUEUE_DEFAULT_SIZE 16
+
+/**
+ * @brief End of the free slot list
+ */
+#define _S_INDEXED_QUEUE_NONE UINT32_MAX
+
+/**
+ * @brief An element slot, addressed by its handle
+ * @param data: user data
+ * @param pos: position in the heap, or next free slot when unused
+ * @param used: 1 if the slot holds an element
+ */
+struct _s_indexed_slot {
+	void *data;
+	uint32_t pos;
+	uint8_t used;
+};
+
+/**
+ * @brief The indexed queue structure
+ * @param ordering: ordering of the queue
+ * @param size: number of elements
+ * @param capacity: number of slots allocated
+ * @param free: first free slot
+ * @param slots: elements, indexed by handle
+ * @param heap: heap of handles
+ */
+struct s_indexed_queue {
+	enum e_ordered ordering;
+	uint32_t size;
+	uint32_t capacity;
+	uint32_t free;
+	struct _s_indexed_slot *slots;
+	uint32_t *heap;
+};
+
+/**
+ * @brief A convenience macro to get the data at a heap position
+ */
+#define m_indexed_queue_data(queue, index) \
+	((queue)->slots[(queue)->heap[index]].data)
+
+/**
+ * @brief A convenience macro to check a handle
+ */
+#define m_indexed_queue_valid(queue, handle) \
+	((handle) < (queue)->capacity && (queue)->slots[handle].used)
+
+/**
+ * @brief Write a handle at a heap position
+ * @param queue[in] : queue to modify
+ * @param index[in] : heap position
+ * @param handle[in] : handle to write
+ */
+static inline void _s_indexed_queue_set(struct s_indexed_queue *queue,
+	uint32_t index, uint32_t handle)
+{
+	queue->heap[index] = handle;
+	queue->slots[handle].pos = index;
+}
+
+/**
+ * @brief Move an element up to its place
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param index[in] : heap position of the element
+ * @return the new position of the element
+ */
+static uint32_t _s_indexed_queue_sift_up(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t index)
+{
+	uint32_t handle = queue->heap[index];
+	void *data = queue->slots[handle].data;
+
+	while (index > 0) {
+		uint32_t parent = m_heap_parent(index, _S_INDEXED_QUEUE_ARITY);
+		if (!m_heap_before(queue->ordering, cmp, data,
+				m_indexed_queue_data(queue, parent)))
+			break;
+		_s_indexed_queue_set(queue, index, queue->heap[parent]);
+		index = parent;
+	}
+	_s_indexed_queue_set(queue, index, handle);
+	return index;
+}
+
+/**
+ * @brief Move an element down to its place
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param index[in] : heap position of the element
+ */
+static void _s_indexed_queue_sift_down(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t index)
+{
+	uint32_t handle = queue->heap[index];
+	void *data = queue->slots[handle].data;
+
+	while (1) {
+		uint32_t child = m_heap_child(index, _S_INDEXED_QUEUE_ARITY);
+		if (child >= queue->size)
+			break;
+
+		uint32_t last = m_min(child + _S_INDEXED_QUEUE_ARITY, queue->size);
+		uint32_t best = child;
+		for (child++; child < last; child++)
+			if (m_heap_before(queue->ordering, cmp,
+					m_indexed_queue_data(queue, child),
+					m_indexed_queue_data(queue, best)))
+				best = child;
+
+		if (!m_heap_before(queue->ordering, cmp,
+				m_indexed_queue_data(queue, best), data))
+			break;
+		_s_indexed_queue_set(queue, index, queue->heap[best]);
+		index = best;
+	}
+	_s_indexed_queue_set(queue, index, handle);
+}
+
+/**
+ * @brief Take an element out of the heap and free its slot
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param handle[in] : valid element handle
+ * @return the data removed
+ */
+static void *_s_indexed_queue_remove(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle)
+{
+	struct _s_indexed_slot *slot = &queue->slots[handle];
+	uint32_t index = slot->pos;
+	void *data = slot->data;
+
+	queue->size--;
+	if (index != queue->size) {
+		/* the last element takes the hole and may go either way */
+		_s_indexed_queue_set(queue, index, queue->heap[queue->size]);
+		if (_s_indexed_queue_sift_up(queue, cmp, index) == index)
+			_s_indexed_queue_sift_down(queue, cmp, index);
+	}
+
+	slot->data = NULL;
+	slot->used = 0;
+	slot->pos = queue->free;
+	queue->free = handle;
+	return data;
+}
+
+/**
+ * @brief Double the number of slots of the queue
+ * @param queue[in] : queue to grow
+ */
+static void _s_indexed_queue_grow(struct s_indexed_queue *queue)
+{
+	uint32_t capacity = (queue->capacity) ? queue->capacity << 1 :
+		_S_INDEXED_QUEUE_DEFAULT_SIZE;
+
+	queue->slots = _realloc(queue->slots,
+		capacity * sizeof(struct _s_indexed_slot));
+	queue->heap = _realloc(queue->heap, capacity * sizeof(uint32_t));
+
+	/* chain the new slots in the free list, lowest handle first */
+	for (uint32_t i = capacity; i-- > queue->capacity;) {
+		queue->slots[i].data = NULL;
+		queue->slots[i].used = 0;
+		queue->slots[i].pos = queue->free;
+		queue->free = i;
+	}
+	queue->capacity = capacity;
+}
+
+struct s_indexed_queue *s_indexed_queue_new(enum e_ordered ordering)
+{
+	struct s_indexed_queue *queue = _malloc(sizeof(struct s_indexed_queue));
+	queue->ordering = ordering;
+	queue->free = _S_INDEXED_QUEUE_NONE;
+	return queue;
+}
+
+void s_indexed_queue_delete(struct s_indexed_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	if (queue->slots) {
+		_free(queue->slots);
+		_free(queue->heap);
+	}
+	_free(queue);
+}
+
+void s_indexed_queue_delete_full(struct s_indexed_queue *queue,
+	t_destroy_func func)
+{
+	m_return_if_fail(queue);
+	m_return_if_fail(func);
+
+	for (uint32_t i = 0; i < queue->size; i++)
+		func(m_indexed_queue_data(queue, i));
+	s_indexed_queue_delete(queue);
+}
+
+uint8_t s_indexed_queue_empty(const struct s_indexed_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	return (queue->size <= 0);
+}
+
+uint32_t s_indexed_queue_size(const struct s_indexed_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->size;
+}
+
+int s_indexed_queue_push(struct s_indexed_queue *queue, t_compare_func cmp,
+	void *data, uint32_t *handle)
+{
+	m_stats_scope(e_stats_indexed_queue_push);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+
+	if (queue->free == _S_INDEXED_QUEUE_NONE)
+		_s_indexed_queue_grow(queue);
+
+	uint32_t h = queue->free;
+	struct _s_indexed_slot *slot = &queue->slots[h];
+	queue->free = slot->pos;
+	slot->data = data;
+	slot->used = 1;
+
+	_s_indexed_queue_set(queue, queue->size, h);
+	queue->size++;
+	_s_indexed_queue_sift_up(queue, cmp, queue->size - 1);
+
+	if (handle)
+		*handle = h;
+	return 0;
+}
+
+void *s_indexed_queue_peek(const struct s_indexed_queue *queue)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(!s_indexed_queue_empty(queue), NULL);
+
+	return m_indexed_queue_data(queue, 0);
+}
+
+void *s_indexed_queue_pop(struct s_indexed_queue *queue, t_compare_func cmp)
+{
+	m_stats_scope(e_stats_indexed_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(!s_indexed_queue_empty(queue), NULL);
+
+	return _s_indexed_queue_remove(queue, cmp, queue->heap[0]);
+}
+
+void *s_indexed_queue_get(const struct s_indexed_queue *queue,
+	uint32_t handle)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(m_indexed_queue_valid(queue, handle), NULL);
+
+	return queue->slots[handle].data;
+}
+
+int s_indexed_queue_decrease_key(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle, void *data)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(m_indexed_queue_valid(queue, handle), -EINVAL);
+
+	queue->slots[handle].data = data;
+	if (queue->ordering == e_ordered_increase)
+		_s_indexed_queue_sift_up(queue, cmp, queue->slots[handle].pos);
+	else
+		_s_indexed_queue_sift_down(queue, cmp, queue->slots[handle].pos);
+	return 0;
+}
+
+int s_indexed_queue_increase_key(struct s_indexed_queue *queue,
+	t_compare_func cmp, uint32_t handle, void *data)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(m_indexed_queue_valid(queue, handle), -EINVAL);
+
+	queue->slots[handle].data = data;
+	if (queue->ordering == e_ordered_increase)
+		_s_indexed_queue_sift_down(queue, cmp, queue->slots[handle].pos);
+	else
+		_s_indexed_queue_sift_up(queue, cmp, queue->slots[handle].pos);
+	return 0;
+}
+
+int s_indexed_queue_update(struct s_indexed_queue *queue, t_compare_func cmp,
+	uint32_t handle, void *data)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(m_indexed_queue_valid(queue, handle), -EINVAL);
+
+	uint32_t index = queue->slots[handle].pos;
+	queue->slots[handle].data = data;
+	if (_s_indexed_queue_sift_up(queue, cmp, index) == index)
+		_s_indexed_queue_sift_down(queue, cmp, index);
+	return 0;
+}
+
+void *s_indexed_queue_erase(struct s_indexed_queue *queue, t_compare_func cmp,
+	uint32_t handle)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(m_indexed_queue_valid(queue, handle), NULL);
+
+	return _s_indexed_queue_remove(queue, cmp, handle);
+}
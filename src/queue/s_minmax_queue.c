@@ -0,0 +1,271 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_minmax_queue.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Initial number of slots of the heap
+ */
+#define _S_MINMAX_QUEUE_DEFAULT_SIZE 16
+
+/**
+ * @brief The double-ended priority queue structure. Elements on even levels
+ * of the heap are smaller than all their descendants, elements on odd levels
+ * are bigger than all their descendants.
+ * @param size: number of elements
+ * @param capacity: number of slots allocated
+ * @param heap: heap storage
+ */
+struct s_minmax_queue {
+	uint32_t size;
+	uint32_t capacity;
+	void **heap;
+};
+
+/**
+ * @brief A convenience macro to know if an index is on a max level
+ */
+#define m_minmax_is_max_level(index) ((31 - __builtin_clz((index) + 1)) & 1)
+
+/**
+ * @brief A convenience macro to compare two elements: on a min level a must
+ * be smaller than b, on a max level bigger
+ */
+#define m_minmax_before(cmp, max, a, b) \
+	((max) ? (cmp)(a, b) > 0 : (cmp)(a, b) < 0)
+
+/**
+ * @brief A convenience macro to swap two slots of the heap
+ */
+#define m_minmax_swap(heap, i, j) { \
+	do { \
+		void *_tmp = (heap)[i]; \
+		(heap)[i] = (heap)[j]; \
+		(heap)[j] = _tmp; \
+	} while (0); \
+}
+
+/**
+ * @brief Move an element up through the levels of its own kind
+ * @param heap[in] : heap storage
+ * @param cmp[in] : comparison operator
+ * @param index[in] : index of the element
+ * @param max[in] : 1 if the element is on a max level
+ */
+static void _s_minmax_bubble_up(void **heap, t_compare_func cmp,
+	uint32_t index, uint8_t max)
+{
+	void *data = heap[index];
+
+	while (index > 2) {
+		uint32_t grand = ((index - 1) / 2 - 1) / 2;
+		if (!m_minmax_before(cmp, max, data, heap[grand]))
+			break;
+		heap[index] = heap[grand];
+		index = grand;
+	}
+	heap[index] = data;
+}
+
+/**
+ * @brief Move an element down to its place
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param index[in] : index of the element
+ */
+static void _s_minmax_trickle_down(struct s_minmax_queue *queue,
+	t_compare_func cmp, uint32_t index)
+{
+	void **heap = queue->heap;
+	uint8_t max = m_minmax_is_max_level(index);
+
+	while (1) {
+		uint32_t child = 2 * index + 1;
+		if (child >= queue->size)
+			break;
+
+		/* best of the children and grandchildren */
+		uint32_t best = child;
+		if (child + 1 < queue->size &&
+				m_minmax_before(cmp, max, heap[child + 1], heap[best]))
+			best = child + 1;
+		uint32_t grand = 2 * child + 1;
+		uint32_t last = m_min(grand + 4, queue->size);
+		for (uint32_t i = grand; i < last; i++)
+			if (m_minmax_before(cmp, max, heap[i], heap[best]))
+				best = i;
+
+		if (!m_minmax_before(cmp, max, heap[best], heap[index]))
+			break;
+		m_minmax_swap(heap, best, index);
+		if (best <= child + 1)
+			break;
+
+		/* a grandchild: keep it ordered with its parent */
+		uint32_t parent = (best - 1) / 2;
+		if (m_minmax_before(cmp, max, heap[parent], heap[best]))
+			m_minmax_swap(heap, best, parent);
+		index = best;
+	}
+}
+
+/**
+ * @brief Remove the element at an index
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @param index[in] : index of the element
+ * @return the data removed
+ */
+static void *_s_minmax_queue_remove(struct s_minmax_queue *queue,
+	t_compare_func cmp, uint32_t index)
+{
+	void *data = queue->heap[index];
+
+	queue->size--;
+	if (index < queue->size) {
+		queue->heap[index] = queue->heap[queue->size];
+		_s_minmax_trickle_down(queue, cmp, index);
+	}
+	return data;
+}
+
+/**
+ * @brief Get the index of the biggest element
+ * @param queue[in] : non empty queue
+ * @param cmp[in] : comparison operator
+ * @return an index
+ */
+static uint32_t _s_minmax_queue_max(const struct s_minmax_queue *queue,
+	t_compare_func cmp)
+{
+	if (queue->size == 1)
+		return 0;
+	if (queue->size == 2 || cmp(queue->heap[1], queue->heap[2]) >= 0)
+		return 1;
+	return 2;
+}
+
+struct s_minmax_queue *s_minmax_queue_new(void)
+{
+	return _malloc(sizeof(struct s_minmax_queue));
+}
+
+void s_minmax_queue_delete(struct s_minmax_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	if (queue->heap)
+		_free(queue->heap);
+	_free(queue);
+}
+
+void s_minmax_queue_delete_full(struct s_minmax_queue *queue,
+	t_destroy_func func)
+{
+	m_return_if_fail(queue);
+	m_return_if_fail(func);
+
+	for (uint32_t i = 0; i < queue->size; i++)
+		func(queue->heap[i]);
+	s_minmax_queue_delete(queue);
+}
+
+uint8_t s_minmax_queue_empty(const struct s_minmax_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	return (queue->size <= 0);
+}
+
+uint32_t s_minmax_queue_size(const struct s_minmax_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->size;
+}
+
+int s_minmax_queue_push(struct s_minmax_queue *queue, t_compare_func cmp,
+	void *data)
+{
+	m_stats_scope(e_stats_minmax_queue_push);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+
+	if (queue->size == queue->capacity) {
+		queue->capacity = (queue->capacity) ? queue->capacity << 1 :
+			_S_MINMAX_QUEUE_DEFAULT_SIZE;
+		queue->heap = _realloc(queue->heap,
+			queue->capacity * sizeof(void *));
+	}
+
+	uint32_t index = queue->size++;
+	queue->heap[index] = data;
+	if (index == 0)
+		return 0;
+
+	/* the element goes up either the min levels or the max levels */
+	uint32_t parent = (index - 1) / 2;
+	uint8_t max = m_minmax_is_max_level(index);
+	if (m_minmax_before(cmp, !max, data, queue->heap[parent])) {
+		m_minmax_swap(queue->heap, index, parent);
+		_s_minmax_bubble_up(queue->heap, cmp, parent, !max);
+	} else {
+		_s_minmax_bubble_up(queue->heap, cmp, index, max);
+	}
+	return 0;
+}
+
+void *s_minmax_queue_peek_min(const struct s_minmax_queue *queue)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(!s_minmax_queue_empty(queue), NULL);
+
+	return queue->heap[0];
+}
+
+void *s_minmax_queue_peek_max(const struct s_minmax_queue *queue,
+	t_compare_func cmp)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(!s_minmax_queue_empty(queue), NULL);
+
+	return queue->heap[_s_minmax_queue_max(queue, cmp)];
+}
+
+void *s_minmax_queue_pop_min(struct s_minmax_queue *queue, t_compare_func cmp)
+{
+	m_stats_scope(e_stats_minmax_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(!s_minmax_queue_empty(queue), NULL);
+
+	return _s_minmax_queue_remove(queue, cmp, 0);
+}
+
+void *s_minmax_queue_pop_max(struct s_minmax_queue *queue, t_compare_func cmp)
+{
+	m_stats_scope(e_stats_minmax_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(!s_minmax_queue_empty(queue), NULL);
+
+	return _s_minmax_queue_remove(queue, cmp,
+		_s_minmax_queue_max(queue, cmp));
+}
@@ -0,0 +1,254 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "queue/s_multi_queue.h"
+#include "queue/s_heap-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief A locked heap, padded to its own cache line
+ * @param lock: protect queue
+ * @param queue: heap storage
+ * @param head: head of queue, only compared to NULL without the lock
+ */
+struct _s_multi_heap {
+	pthread_mutex_t lock;
+	struct s_ordered_queue *queue;
+	_Atomic(void *) head;
+} __attribute__((aligned(64)));
+
+/**
+ * @brief The concurrent relaxed priority queue structure
+ * @param ordering: ordering of the queue
+ * @param size: number of heaps
+ * @param heaps: heaps array
+ */
+struct s_multi_queue {
+	enum e_ordered ordering;
+	uint32_t size;
+	struct _s_multi_heap *heaps;
+};
+
+/**
+ * @brief State of the heap random generator of the calling thread
+ */
+static __thread uint64_t _s_multi_seed;
+
+/**
+ * @brief Pick a random heap (xorshift64)
+ * @param queue[in] : queue to investigate
+ * @return an index in the heaps array
+ */
+static uint32_t _s_multi_queue_random(const struct s_multi_queue *queue)
+{
+	uint64_t x = _s_multi_seed;
+
+	if (!x)
+		x = 0x9e3779b97f4a7c15ULL * ((uintptr_t)&_s_multi_seed | 1);
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	_s_multi_seed = x;
+	return (uint32_t)(x % queue->size);
+}
+
+/**
+ * @brief Pop the head of a locked heap and publish the new head
+ * @param heap[in] : locked heap
+ * @param cmp[in] : comparison operator
+ * @return a data pointer, NULL if the heap is empty
+ */
+static void *_s_multi_heap_pop(struct _s_multi_heap *heap, t_compare_func cmp)
+{
+	if (s_ordered_queue_empty(heap->queue))
+		return NULL;
+
+	void *data = s_ordered_queue_pop(heap->queue, cmp);
+	atomic_store_explicit(&heap->head, s_ordered_queue_empty(heap->queue) ?
+		NULL : s_ordered_queue_peek(heap->queue), memory_order_release);
+	return data;
+}
+
+/**
+ * @brief Pop from the first non empty heap, waiting for the locks. Used when
+ * the random picks only found empty heaps.
+ * @param queue[in] : queue to modify
+ * @param cmp[in] : comparison operator
+ * @return a data pointer, NULL if all the heaps are empty
+ */
+static void *_s_multi_queue_scan(struct s_multi_queue *queue,
+	t_compare_func cmp)
+{
+	uint32_t start = _s_multi_queue_random(queue);
+
+	for (uint32_t i = 0; i < queue->size; i++) {
+		struct _s_multi_heap *heap = &queue->heaps[(start + i) %
+			queue->size];
+		if (!atomic_load_explicit(&heap->head, memory_order_acquire))
+			continue;
+
+		pthread_mutex_lock(&heap->lock);
+		void *data = _s_multi_heap_pop(heap, cmp);
+		pthread_mutex_unlock(&heap->lock);
+		if (data)
+			return data;
+	}
+	return NULL;
+}
+
+struct s_multi_queue *s_multi_queue_new(enum e_ordered ordering,
+	uint32_t heaps)
+{
+	if (!heaps) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		heaps = (cpus > 0) ? 2 * (uint32_t)cpus : 2;
+	}
+
+	struct s_multi_queue *queue = _malloc(sizeof(struct s_multi_queue));
+	queue->ordering = ordering;
+	queue->size = heaps;
+	queue->heaps = _calloc(sizeof(struct _s_multi_heap), heaps);
+	for (uint32_t i = 0; i < heaps; i++) {
+		pthread_mutex_init(&queue->heaps[i].lock, NULL);
+		queue->heaps[i].queue = s_ordered_queue_new(ordering);
+		atomic_init(&queue->heaps[i].head, NULL);
+	}
+	return queue;
+}
+
+/**
+ * @brief Release the heaps of a queue
+ * @param queue[in] : queue to clean
+ * @param func[in] : optional delete function for the remaining user data
+ */
+static void _s_multi_queue_clean(struct s_multi_queue *queue,
+	t_destroy_func func)
+{
+	for (uint32_t i = 0; i < queue->size; i++) {
+		if (func)
+			s_ordered_queue_delete_full(queue->heaps[i].queue, func);
+		else
+			s_ordered_queue_delete(queue->heaps[i].queue);
+		pthread_mutex_destroy(&queue->heaps[i].lock);
+	}
+	_free(queue->heaps);
+}
+
+void s_multi_queue_delete(struct s_multi_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	_s_multi_queue_clean(queue, NULL);
+	_free(queue);
+}
+
+void s_multi_queue_delete_full(struct s_multi_queue *queue,
+	t_destroy_func func)
+{
+	m_return_if_fail(queue);
+	m_return_if_fail(func);
+
+	_s_multi_queue_clean(queue, func);
+	_free(queue);
+}
+
+uint8_t s_multi_queue_empty(const struct s_multi_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	for (uint32_t i = 0; i < queue->size; i++)
+		if (atomic_load_explicit(&queue->heaps[i].head,
+				memory_order_acquire))
+			return 0;
+	return 1;
+}
+
+int s_multi_queue_push(struct s_multi_queue *queue, t_compare_func cmp,
+	void *data)
+{
+	m_stats_scope(e_stats_multi_queue_push);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(data, -EINVAL);
+
+	struct _s_multi_heap *heap;
+	do {
+		heap = &queue->heaps[_s_multi_queue_random(queue)];
+	} while (queue->size > 1 && pthread_mutex_trylock(&heap->lock) != 0);
+	if (queue->size == 1)
+		pthread_mutex_lock(&heap->lock);
+
+	s_ordered_queue_push(heap->queue, cmp, data);
+	atomic_store_explicit(&heap->head, s_ordered_queue_peek(heap->queue),
+		memory_order_release);
+	pthread_mutex_unlock(&heap->lock);
+	return 0;
+}
+
+void *s_multi_queue_pop(struct s_multi_queue *queue, t_compare_func cmp)
+{
+	m_stats_scope(e_stats_multi_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+
+	if (queue->size == 1)
+		return _s_multi_queue_scan(queue, cmp);
+
+	while (1) {
+		struct _s_multi_heap *a = &queue->heaps[
+			_s_multi_queue_random(queue)];
+		struct _s_multi_heap *b = &queue->heaps[
+			_s_multi_queue_random(queue)];
+
+		if (!atomic_load_explicit(&a->head, memory_order_acquire))
+			a = b;
+		if (!atomic_load_explicit(&b->head, memory_order_acquire))
+			b = a;
+		if (!atomic_load_explicit(&a->head, memory_order_acquire))
+			return _s_multi_queue_scan(queue, cmp);
+
+		/*
+		 * the heads can only be compared under the locks: once
+		 * unlocked, a head may be popped and released by its owner
+		 */
+		if (pthread_mutex_trylock(&a->lock) != 0)
+			continue;
+		if (b != a && pthread_mutex_trylock(&b->lock) != 0) {
+			pthread_mutex_unlock(&a->lock);
+			continue;
+		}
+
+		struct _s_multi_heap *best = a;
+		if (b != a && !s_ordered_queue_empty(b->queue) &&
+				(s_ordered_queue_empty(a->queue) ||
+				m_heap_before(queue->ordering, cmp,
+					s_ordered_queue_peek(b->queue),
+					s_ordered_queue_peek(a->queue))))
+			best = b;
+
+		void *data = _s_multi_heap_pop(best, cmp);
+		if (b != a)
+			pthread_mutex_unlock(&b->lock);
+		pthread_mutex_unlock(&a->lock);
+		if (data)
+			return data;
+	}
+}
@@ -14,21 +14,85 @@
  * You should have received a copy of the GNU General Public License
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
+#include <string.h>
 #include "queue/s_ordered_queue.h"
-#include "tree/s_rb_tree.h"
+#include "queue/s_heap-private.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
+/**
+ * @brief Default number of children per heap element
+ */
+#define _S_ORDERED_QUEUE_DEFAULT_ARITY 4
+
+/**
+ * @brief Initial number of slots of the heap
+ */
+#define _S_ORDERED_QUEUE_DEFAULT_SIZE 16
+
+/**
+ * @brief The ordered queue structure
+ * @param ordering: ordering of the queue
+ * @param arity: number of children per heap element
+ * @param size: number of elements
+ * @param capacity: number of slots allocated
+ * @param heap: heap storage
+ */
 struct s_ordered_queue {
 	enum e_ordered ordering;
-	struct s_rb_tree *root;
+	uint8_t arity;
 	uint32_t size;
+	uint32_t capacity;
+	void **heap;
 };
 
-struct s_ordered_queue *s_ordered_queue_new(enum e_ordered ordering)
+struct s_ordered_queue *s_ordered_queue_new_with_arity(
+	enum e_ordered ordering, uint8_t arity)
 {
+	m_return_val_if_fail(arity >= 2, NULL);
+
 	struct s_ordered_queue *queue = _malloc(sizeof(struct s_ordered_queue));
 	queue->ordering = ordering;
+	queue->arity = arity;
+	return queue;
+}
+
+struct s_ordered_queue *s_ordered_queue_new(enum e_ordered ordering)
+{
+	return s_ordered_queue_new_with_arity(ordering,
+		_S_ORDERED_QUEUE_DEFAULT_ARITY);
+}
+
+/**
+ * @brief Make room for more elements
+ * @param queue[in] : queue to modify
+ * @param size[in] : number of elements to add
+ */
+static void _s_ordered_queue_reserve(struct s_ordered_queue *queue,
+	uint32_t size)
+{
+	if (queue->size + size <= queue->capacity)
+		return;
+
+	uint32_t capacity = (queue->capacity) ? queue->capacity :
+		_S_ORDERED_QUEUE_DEFAULT_SIZE;
+	while (capacity < queue->size + size)
+		capacity <<= 1;
+	queue->capacity = capacity;
+	queue->heap = _realloc(queue->heap, capacity * sizeof(void *));
+}
+
+struct s_ordered_queue *s_ordered_queue_new_from_array(
+	enum e_ordered ordering, t_compare_func cmp, void **data,
+	uint32_t size)
+{
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(data || !size, NULL);
+
+	/* timed as a bulk push by s_ordered_queue_push_n() */
+	struct s_ordered_queue *queue = s_ordered_queue_new(ordering);
+	s_ordered_queue_push_n(queue, cmp, data, size);
 	return queue;
 }
 
@@ -36,8 +100,8 @@ void s_ordered_queue_delete(struct s_ordered_queue *queue)
 {
 	m_return_if_fail(queue);
 
-	if (queue->root)
-		s_rb_tree_delete(queue->root);
+	if (queue->heap)
+		_free(queue->heap);
 	_free(queue);
 }
 
@@ -45,10 +109,11 @@ void s_ordered_queue_delete_full(struct s_ordered_queue *queue,
 	t_destroy_func func)
 {
 	m_return_if_fail(queue);
+	m_return_if_fail(func);
 
-	if (queue->root)
-		s_rb_tree_delete_full(queue->root, func);
-	_free(queue);
+	for (uint32_t i = 0; i < queue->size; i++)
+		func(queue->heap[i]);
+	s_ordered_queue_delete(queue);
 }
 
 uint8_t s_ordered_queue_empty(const struct s_ordered_queue *queue)
@@ -58,37 +123,84 @@ uint8_t s_ordered_queue_empty(const struct s_ordered_queue *queue)
 	return (queue->size <= 0);
 }
 
+uint32_t s_ordered_queue_size(const struct s_ordered_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->size;
+}
+
+void *s_ordered_queue_peek(const struct s_ordered_queue *queue)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(!s_ordered_queue_empty(queue), NULL);
+
+	return queue->heap[0];
+}
+
 void *s_ordered_queue_pop(struct s_ordered_queue *queue, t_compare_func cmp)
 {
+	m_stats_scope(e_stats_ordered_queue_pop);
 	m_return_val_if_fail(queue, NULL);
 	m_return_val_if_fail(cmp, NULL);
 	m_return_val_if_fail(!s_ordered_queue_empty(queue), NULL);
 
-	void *data = NULL;
-	switch (queue->ordering) {
-	case e_ordered_increase:
-		data = s_rb_tree_nth_smallest(queue->root, 1);
-		break;
-	case e_ordered_decrease:
-		data = s_rb_tree_nth_smallest(queue->root, queue->size - 1);
-		break;
+	void *data = queue->heap[0];
+	queue->size--;
+	if (queue->size > 0) {
+		queue->heap[0] = queue->heap[queue->size];
+		_s_heap_sift_down(queue->heap, queue->size, 0, queue->arity,
+			queue->ordering, cmp);
 	}
-
-	if (s_rb_tree_exist(queue->root, cmp, data) == 0) {
-		queue->root = s_rb_tree_remove(queue->root, cmp, NULL, data);
-		queue->size--;
-	}
-
 	return data;
 }
 
 int s_ordered_queue_push(struct s_ordered_queue *queue, t_compare_func cmp,
 	void *data)
 {
+	m_stats_scope(e_stats_ordered_queue_push);
 	m_return_val_if_fail(queue, -EINVAL);
 	m_return_val_if_fail(cmp, -EINVAL);
 
-	queue->root = s_rb_tree_add(queue->root, cmp, data);
+	_s_ordered_queue_reserve(queue, 1);
+	queue->heap[queue->size] = data;
+	_s_heap_sift_up(queue->heap, queue->size, queue->arity,
+		queue->ordering, cmp);
 	queue->size++;
 	return 0;
 }
+
+int s_ordered_queue_push_n(struct s_ordered_queue *queue, t_compare_func cmp,
+	void **data, uint32_t size)
+{
+	m_stats_scope(e_stats_ordered_queue_push_n);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(data || !size, -EINVAL);
+
+	if (!size)
+		return 0;
+
+	_s_ordered_queue_reserve(queue, size);
+	memcpy(queue->heap + queue->size, data, size * sizeof(void *));
+
+	/*
+	 * sifting each element up costs size * log(total), a rebuild costs
+	 * total: rebuild when the batch is big enough for that to pay
+	 */
+	uint32_t total = queue->size + size;
+	uint32_t depth = 32 - __builtin_clz(total);
+	if ((uint64_t)size * depth >= total) {
+		queue->size = total;
+		_s_heap_make(queue->heap, total, queue->arity, queue->ordering,
+			cmp);
+		return 0;
+	}
+
+	while (queue->size < total) {
+		_s_heap_sift_up(queue->heap, queue->size, queue->arity,
+			queue->ordering, cmp);
+		queue->size++;
+	}
+	return 0;
+}
@@ -0,0 +1,235 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_pairing_queue.h"
+#include "queue/s_heap-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief A node of the pairing heap
+ * @param data: user data
+ * @param child: first child
+ * @param sibling: next sibling
+ */
+struct _s_pairing_node {
+	void *data;
+	struct _s_pairing_node *child;
+	struct _s_pairing_node *sibling;
+};
+
+/**
+ * @brief The meldable ordered queue structure
+ * @param ordering: ordering of the queue
+ * @param size: number of elements
+ * @param root: heap root
+ */
+struct s_pairing_queue {
+	enum e_ordered ordering;
+	uint32_t size;
+	struct _s_pairing_node *root;
+};
+
+/**
+ * @brief Link two heaps, the root coming last becomes the first child of the
+ * other one
+ * @param ordering[in] : heap ordering
+ * @param cmp[in] : comparison operator
+ * @param a[in] : heap without sibling
+ * @param b[in] : heap without sibling
+ * @return the new root
+ */
+static struct _s_pairing_node *_s_pairing_link(enum e_ordered ordering,
+	t_compare_func cmp, struct _s_pairing_node *a,
+	struct _s_pairing_node *b)
+{
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+
+	if (m_heap_before(ordering, cmp, b->data, a->data)) {
+		struct _s_pairing_node *tmp = a;
+		a = b;
+		b = tmp;
+	}
+	b->sibling = a->child;
+	a->child = b;
+	return a;
+}
+
+/**
+ * @brief Merge the children of a popped root (two-pass pairing). The first
+ * pass links the children by pairs from the left, the second one links the
+ * pairs from the right. Both are iterative, the pairs being chained in
+ * reverse order through sibling.
+ * @param ordering[in] : heap ordering
+ * @param cmp[in] : comparison operator
+ * @param list[in] : first child
+ * @return the new root
+ */
+static struct _s_pairing_node *_s_pairing_merge(enum e_ordered ordering,
+	t_compare_func cmp, struct _s_pairing_node *list)
+{
+	struct _s_pairing_node *pairs = NULL;
+
+	while (list) {
+		struct _s_pairing_node *a = list;
+		struct _s_pairing_node *b = a->sibling;
+		list = (b) ? b->sibling : NULL;
+
+		a->sibling = NULL;
+		if (b)
+			b->sibling = NULL;
+		a = _s_pairing_link(ordering, cmp, a, b);
+		a->sibling = pairs;
+		pairs = a;
+	}
+
+	struct _s_pairing_node *root = NULL;
+	while (pairs) {
+		struct _s_pairing_node *next = pairs->sibling;
+		pairs->sibling = NULL;
+		root = _s_pairing_link(ordering, cmp, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+struct s_pairing_queue *s_pairing_queue_new(enum e_ordered ordering)
+{
+	struct s_pairing_queue *queue = _malloc(sizeof(struct s_pairing_queue));
+	queue->ordering = ordering;
+	return queue;
+}
+
+/**
+ * @brief Release the nodes of a queue without recursion: the children of a
+ * node are spliced in front of its siblings before it is released
+ * @param queue[in] : queue to clean
+ * @param func[in] : optional delete function for the remaining user data
+ */
+static void _s_pairing_queue_clean(struct s_pairing_queue *queue,
+	t_destroy_func func)
+{
+	struct _s_pairing_node *node = queue->root;
+
+	while (node) {
+		if (node->child) {
+			struct _s_pairing_node *last = node->child;
+			while (last->sibling)
+				last = last->sibling;
+			last->sibling = node->sibling;
+			node->sibling = node->child;
+		}
+
+		struct _s_pairing_node *next = node->sibling;
+		if (func)
+			func(node->data);
+		_free(node);
+		node = next;
+	}
+	queue->root = NULL;
+	queue->size = 0;
+}
+
+void s_pairing_queue_delete(struct s_pairing_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	_s_pairing_queue_clean(queue, NULL);
+	_free(queue);
+}
+
+void s_pairing_queue_delete_full(struct s_pairing_queue *queue,
+	t_destroy_func func)
+{
+	m_return_if_fail(queue);
+	m_return_if_fail(func);
+
+	_s_pairing_queue_clean(queue, func);
+	_free(queue);
+}
+
+uint8_t s_pairing_queue_empty(const struct s_pairing_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	return (queue->size <= 0);
+}
+
+uint32_t s_pairing_queue_size(const struct s_pairing_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->size;
+}
+
+int s_pairing_queue_push(struct s_pairing_queue *queue, t_compare_func cmp,
+	void *data)
+{
+	m_stats_scope(e_stats_pairing_queue_push);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+
+	struct _s_pairing_node *node = _malloc(sizeof(struct _s_pairing_node));
+	node->data = data;
+	queue->root = _s_pairing_link(queue->ordering, cmp, queue->root, node);
+	queue->size++;
+	return 0;
+}
+
+void *s_pairing_queue_peek(const struct s_pairing_queue *queue)
+{
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(!s_pairing_queue_empty(queue), NULL);
+
+	return queue->root->data;
+}
+
+void *s_pairing_queue_pop(struct s_pairing_queue *queue, t_compare_func cmp)
+{
+	m_stats_scope(e_stats_pairing_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(cmp, NULL);
+	m_return_val_if_fail(!s_pairing_queue_empty(queue), NULL);
+
+	struct _s_pairing_node *root = queue->root;
+	void *data = root->data;
+
+	queue->root = _s_pairing_merge(queue->ordering, cmp, root->child);
+	queue->size--;
+	_free(root);
+	return data;
+}
+
+int s_pairing_queue_meld(struct s_pairing_queue *queue,
+	struct s_pairing_queue *other, t_compare_func cmp)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(other, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(queue != other, -EINVAL);
+	m_return_val_if_fail(queue->ordering == other->ordering, -EINVAL);
+
+	queue->root = _s_pairing_link(queue->ordering, cmp, queue->root,
+		other->root);
+	queue->size += other->size;
+	other->root = NULL;
+	other->size = 0;
+	return 0;
+}
@@ -16,6 +16,7 @@
  */
 #include "queue/s_queue.h"
 #include "list/s_d_list.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -60,6 +61,7 @@ uint8_t s_queue_empty(const struct s_queue *queue)
 
 void *s_queue_pop(struct s_queue *queue)
 {
+	m_stats_scope(e_stats_queue_pop);
 	m_return_val_if_fail(queue, NULL);
 
 	struct s_d_list *tail = queue->tail;
@@ -75,6 +77,7 @@ void *s_queue_pop(struct s_queue *queue)
 
 int s_queue_push(struct s_queue *queue, void *data)
 {
+	m_stats_scope(e_stats_queue_push);
 	m_return_val_if_fail(queue, -EINVAL);
 	m_return_val_if_fail(data, -EINVAL);
 
@@ -0,0 +1,214 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_radix_queue.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Number of buckets: keys equal to last, then one per highest bit
+ * differing from last
+ */
+#define _S_RADIX_QUEUE_BUCKETS 65
+
+/**
+ * @brief Initial number of entries of a bucket
+ */
+#define _S_RADIX_QUEUE_DEFAULT_SIZE 8
+
+/**
+ * @brief An element of the queue
+ * @param key: priority
+ * @param data: user data
+ */
+struct _s_radix_entry {
+	uint64_t key;
+	void *data;
+};
+
+/**
+ * @brief A bucket of elements
+ * @param size: number of entries
+ * @param capacity: number of entries allocated
+ * @param entries: storage
+ */
+struct _s_radix_bucket {
+	uint32_t size;
+	uint32_t capacity;
+	struct _s_radix_entry *entries;
+};
+
+/**
+ * @brief The radix queue structure. Bucket i > 0 holds the keys whose highest
+ * bit differing from last is bit i - 1.
+ * @param last: last key popped
+ * @param size: number of elements
+ * @param used: non empty buckets, bit i - 1 for bucket i > 0
+ * @param buckets: elements
+ */
+struct s_radix_queue {
+	uint64_t last;
+	uint32_t size;
+	uint64_t used;
+	struct _s_radix_bucket buckets[_S_RADIX_QUEUE_BUCKETS];
+};
+
+/**
+ * @brief A convenience macro to get the bucket of a key
+ */
+#define m_radix_queue_bucket(last, key) \
+	(((key) == (last)) ? 0 : 64 - __builtin_clzll((key) ^ (last)))
+
+/**
+ * @brief Append an element to the bucket matching its key
+ * @param queue[in] : queue to modify
+ * @param key[in] : priority
+ * @param data[in] : user data
+ */
+static void _s_radix_queue_insert(struct s_radix_queue *queue, uint64_t key,
+	void *data)
+{
+	uint32_t index = m_radix_queue_bucket(queue->last, key);
+	struct _s_radix_bucket *bucket = &queue->buckets[index];
+
+	if (bucket->size == bucket->capacity) {
+		bucket->capacity = (bucket->capacity) ? bucket->capacity << 1 :
+			_S_RADIX_QUEUE_DEFAULT_SIZE;
+		bucket->entries = _realloc(bucket->entries,
+			bucket->capacity * sizeof(struct _s_radix_entry));
+	}
+	bucket->entries[bucket->size].key = key;
+	bucket->entries[bucket->size].data = data;
+	bucket->size++;
+	if (index)
+		queue->used |= 1ULL << (index - 1);
+}
+
+/**
+ * @brief Refill bucket 0: move last to the smallest key of the first non
+ * empty bucket, and spread that bucket into the lower ones. Each element
+ * only moves to a lower bucket, hence the amortized cost.
+ * @param queue[in] : non empty queue with bucket 0 empty
+ */
+static void _s_radix_queue_refill(struct s_radix_queue *queue)
+{
+	uint32_t index = __builtin_ctzll(queue->used) + 1;
+	struct _s_radix_bucket *bucket = &queue->buckets[index];
+	uint64_t min = bucket->entries[0].key;
+
+	for (uint32_t i = 1; i < bucket->size; i++)
+		min = m_min(min, bucket->entries[i].key);
+
+	queue->last = min;
+	queue->used &= ~(1ULL << (index - 1));
+
+	uint32_t size = bucket->size;
+	bucket->size = 0;
+	for (uint32_t i = 0; i < size; i++)
+		_s_radix_queue_insert(queue, bucket->entries[i].key,
+			bucket->entries[i].data);
+}
+
+struct s_radix_queue *s_radix_queue_new(void)
+{
+	return _malloc(sizeof(struct s_radix_queue));
+}
+
+/**
+ * @brief Release the buckets of a queue
+ * @param queue[in] : queue to clean
+ * @param func[in] : optional delete function for the remaining user data
+ */
+static void _s_radix_queue_clean(struct s_radix_queue *queue,
+	t_destroy_func func)
+{
+	for (uint32_t i = 0; i < _S_RADIX_QUEUE_BUCKETS; i++) {
+		struct _s_radix_bucket *bucket = &queue->buckets[i];
+		if (func)
+			for (uint32_t j = 0; j < bucket->size; j++)
+				func(bucket->entries[j].data);
+		if (bucket->entries)
+			_free(bucket->entries);
+	}
+}
+
+void s_radix_queue_delete(struct s_radix_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	_s_radix_queue_clean(queue, NULL);
+	_free(queue);
+}
+
+void s_radix_queue_delete_full(struct s_radix_queue *queue,
+	t_destroy_func func)
+{
+	m_return_if_fail(queue);
+	m_return_if_fail(func);
+
+	_s_radix_queue_clean(queue, func);
+	_free(queue);
+}
+
+uint8_t s_radix_queue_empty(const struct s_radix_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	return (queue->size <= 0);
+}
+
+uint32_t s_radix_queue_size(const struct s_radix_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->size;
+}
+
+uint64_t s_radix_queue_last(const struct s_radix_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	return queue->last;
+}
+
+int s_radix_queue_push(struct s_radix_queue *queue, uint64_t key, void *data)
+{
+	m_stats_scope(e_stats_radix_queue_push);
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(key >= queue->last, -EINVAL);
+
+	_s_radix_queue_insert(queue, key, data);
+	queue->size++;
+	return 0;
+}
+
+void *s_radix_queue_pop(struct s_radix_queue *queue, uint64_t *key)
+{
+	m_stats_scope(e_stats_radix_queue_pop);
+	m_return_val_if_fail(queue, NULL);
+	m_return_val_if_fail(!s_radix_queue_empty(queue), NULL);
+
+	if (queue->buckets[0].size == 0)
+		_s_radix_queue_refill(queue);
+
+	struct _s_radix_bucket *bucket = &queue->buckets[0];
+	bucket->size--;
+	queue->size--;
+	if (key)
+		*key = bucket->entries[bucket->size].key;
+	return bucket->entries[bucket->size].data;
+}
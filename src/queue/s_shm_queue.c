@@ -0,0 +1,473 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "queue/s_shm_queue.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+#define _S_SHM_QUEUE_MAGIC 0x53484d51
+#define _S_SHM_QUEUE_VERSION 1
+#define _S_SHM_QUEUE_MIN_SIZE 4096
+#define _S_SHM_QUEUE_CACHE_LINE 64
+
+/**
+ * @brief Length of the record written when a message does not fit before the
+ * end of the ring: the consumer skip to the beginning.
+ */
+#define _S_SHM_QUEUE_WRAP UINT32_MAX
+
+/**
+ * @brief A futex based event
+ * @param seq: bumped on each notification, the futex word
+ * @param waiters: number of waiters, to skip the wake up syscall
+ */
+struct _s_shm_event {
+	_Atomic uint32_t seq;
+	_Atomic uint32_t waiters;
+};
+
+/**
+ * @brief Header at the beginning of the mapping, all the positions are
+ * offsets so the mapping address may differ between processes.
+ * @param magic: _S_SHM_QUEUE_MAGIC
+ * @param version: layout version
+ * @param size: ring size in bytes (power of 2)
+ * @param data: offset of the ring from the beginning of the mapping
+ * @param head: bytes consumed since the creation, written by the consumer
+ * @param released: signaled by the consumer when room is given back
+ * @param tail: bytes produced since the creation, written by the producer
+ * @param committed: signaled by the producer when a message is published
+ */
+struct _s_shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+	uint64_t data;
+	_Alignas(_S_SHM_QUEUE_CACHE_LINE) _Atomic uint64_t head;
+	struct _s_shm_event released;
+	_Alignas(_S_SHM_QUEUE_CACHE_LINE) _Atomic uint64_t tail;
+	struct _s_shm_event committed;
+};
+
+/**
+ * @brief Header of each message in the ring, followed by the message padded
+ * to 8 bytes
+ * @param len: message size or _S_SHM_QUEUE_WRAP
+ * @param reserved: padding
+ */
+struct _s_shm_record {
+	uint32_t len;
+	uint32_t reserved;
+};
+
+/**
+ * @brief The shared memory queue structure (process local)
+ * @param header: beginning of the mapping
+ * @param ring: the ring in this process
+ * @param length: size of the mapping
+ * @param fd: shared memory file descriptor
+ * @param reserved: bytes reserved by the producer but not committed yet
+ * @param wrap: offset of the wrap record to write on commit, or UINT64_MAX
+ * @param peeked: bytes peeked by the consumer but not released yet
+ */
+struct s_shm_queue {
+	struct _s_shm_header *header;
+	uint8_t *ring;
+	uint64_t length;
+	int fd;
+	uint64_t reserved;
+	uint64_t wrap;
+	uint64_t peeked;
+};
+
+/**
+ * @brief Convenience macro to get the room used by a message
+ */
+#define m_shm_queue_record_size(len) \
+	(sizeof(struct _s_shm_record) + (((uint64_t)(len) + 7) & ~7ULL))
+
+/**
+ * @brief Get a monotonic timestamp
+ * @return a timestamp in milliseconds
+ */
+static int64_t _s_shm_queue_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Wait for an event notification
+ * @param event[in] : event to wait
+ * @param seq[in] : sequence read before checking the condition
+ * @param deadline[in] : absolute timeout in milliseconds, < 0 for none
+ * @return 0 on wake up, -errno on error
+ */
+static int _s_shm_event_wait(struct _s_shm_event *event, uint32_t seq,
+	int64_t deadline)
+{
+	struct timespec ts, *timeout = NULL;
+
+	if (deadline >= 0) {
+		int64_t left = deadline - _s_shm_queue_now();
+		if (left <= 0)
+			return -ETIMEDOUT;
+		ts.tv_sec = left / 1000;
+		ts.tv_nsec = (left % 1000) * 1000000;
+		timeout = &ts;
+	}
+
+	if (syscall(SYS_futex, &event->seq, FUTEX_WAIT, seq, timeout, NULL,
+			0) < 0 && errno != EAGAIN && errno != EINTR)
+		return -errno;
+	return 0;
+}
+
+/**
+ * @brief Notify an event, waking up its waiters if any
+ * @param event[in] : event to signal
+ */
+static void _s_shm_event_signal(struct _s_shm_event *event)
+{
+	atomic_fetch_add(&event->seq, 1);
+	if (atomic_load(&event->waiters))
+		syscall(SYS_futex, &event->seq, FUTEX_WAKE, INT_MAX, NULL,
+			NULL, 0);
+}
+
+/**
+ * @brief Map a shared memory queue and check its header
+ * @param fd[in] : shared memory file descriptor, owned on success
+ * @param size[in] : ring size to initialize, 0 to map an existing queue
+ * @return a valid pointer on success, NULL on error
+ */
+static struct s_shm_queue *_s_shm_queue_map(int fd, uint64_t size)
+{
+	uint64_t offset = (sizeof(struct _s_shm_header) +
+		_S_SHM_QUEUE_CACHE_LINE - 1) & ~(uint64_t)(_S_SHM_QUEUE_CACHE_LINE - 1);
+	uint64_t length = offset + size;
+
+	if (size) {
+		if (ftruncate(fd, length) < 0) {
+			m_errno_print(errno);
+			return NULL;
+		}
+	} else {
+		struct stat st;
+		if (fstat(fd, &st) < 0) {
+			m_errno_print(errno);
+			return NULL;
+		}
+		length = st.st_size;
+		m_return_val_if_fail(length > sizeof(struct _s_shm_header),
+			NULL);
+	}
+
+	void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		0);
+	if (map == MAP_FAILED) {
+		m_errno_print(errno);
+		return NULL;
+	}
+
+	struct _s_shm_header *header = map;
+	if (size) {
+		header->version = _S_SHM_QUEUE_VERSION;
+		header->size = size;
+		header->data = offset;
+		atomic_store(&header->head, 0);
+		atomic_store(&header->tail, 0);
+		atomic_store_explicit((_Atomic uint32_t *)&header->magic,
+			_S_SHM_QUEUE_MAGIC, memory_order_release);
+	} else if (atomic_load_explicit((_Atomic uint32_t *)&header->magic,
+			memory_order_acquire) != _S_SHM_QUEUE_MAGIC ||
+			header->version != _S_SHM_QUEUE_VERSION ||
+			header->data + header->size > length) {
+		m_error_print("%s: not a shared memory queue\n", __func__);
+		munmap(map, length);
+		return NULL;
+	}
+
+	struct s_shm_queue *queue = _malloc(sizeof(struct s_shm_queue));
+	queue->header = header;
+	queue->ring = (uint8_t *)map + header->data;
+	queue->length = length;
+	queue->fd = fd;
+	queue->wrap = UINT64_MAX;
+	return queue;
+}
+
+struct s_shm_queue *s_shm_queue_new(const char *name, uint32_t size)
+{
+	m_return_val_if_fail(size > 0, NULL);
+
+	uint64_t ring = _S_SHM_QUEUE_MIN_SIZE;
+	while (ring < size)
+		ring <<= 1;
+
+	int fd = (name) ?
+		shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600) :
+		memfd_create("s_shm_queue", MFD_CLOEXEC);
+	if (fd < 0) {
+		m_errno_print(errno);
+		return NULL;
+	}
+
+	struct s_shm_queue *queue = _s_shm_queue_map(fd, ring);
+	if (!queue) {
+		close(fd);
+		if (name)
+			shm_unlink(name);
+	}
+	return queue;
+}
+
+struct s_shm_queue *s_shm_queue_open(const char *name)
+{
+	m_return_val_if_fail(name, NULL);
+
+	int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+	if (fd < 0) {
+		m_errno_print(errno);
+		return NULL;
+	}
+
+	struct s_shm_queue *queue = _s_shm_queue_map(fd, 0);
+	if (!queue)
+		close(fd);
+	return queue;
+}
+
+struct s_shm_queue *s_shm_queue_open_fd(int fd)
+{
+	m_return_val_if_fail(fd >= 0, NULL);
+
+	int dup = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (dup < 0) {
+		m_errno_print(errno);
+		return NULL;
+	}
+
+	struct s_shm_queue *queue = _s_shm_queue_map(dup, 0);
+	if (!queue)
+		close(dup);
+	return queue;
+}
+
+void s_shm_queue_delete(struct s_shm_queue *queue)
+{
+	m_return_if_fail(queue);
+
+	munmap(queue->header, queue->length);
+	close(queue->fd);
+	_free(queue);
+}
+
+int s_shm_queue_unlink(const char *name)
+{
+	m_return_val_if_fail(name, -EINVAL);
+
+	return (shm_unlink(name) < 0) ? -errno : 0;
+}
+
+int s_shm_queue_fd(const struct s_shm_queue *queue)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+
+	return queue->fd;
+}
+
+uint32_t s_shm_queue_max_size(const struct s_shm_queue *queue)
+{
+	m_return_val_if_fail(queue, 0);
+
+	/* a message may need to wrap: half the ring is always reachable */
+	return (uint32_t)m_min(queue->header->size / 2 -
+		sizeof(struct _s_shm_record), (uint64_t)UINT32_MAX - 8);
+}
+
+uint8_t s_shm_queue_empty(const struct s_shm_queue *queue)
+{
+	m_return_val_if_fail(queue, 1);
+
+	return atomic_load(&queue->header->head) ==
+		atomic_load(&queue->header->tail);
+}
+
+int s_shm_queue_reserve(struct s_shm_queue *queue, uint32_t len,
+	void **data, int32_t timeout)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(data, -EINVAL);
+	m_return_val_if_fail(!queue->reserved, -EBUSY);
+	m_return_val_if_fail(len <= s_shm_queue_max_size(queue), -EMSGSIZE);
+
+	struct _s_shm_header *header = queue->header;
+	uint64_t mask = header->size - 1;
+	uint64_t tail = atomic_load_explicit(&header->tail,
+		memory_order_relaxed);
+	uint64_t need = m_shm_queue_record_size(len);
+	uint64_t contiguous = header->size - (tail & mask);
+	uint64_t total = (need > contiguous) ? contiguous + need : need;
+	int64_t deadline = (timeout > 0) ? _s_shm_queue_now() + timeout : -1;
+
+	while (header->size - (tail - atomic_load(&header->head)) < total) {
+		if (!timeout)
+			return -EAGAIN;
+
+		uint32_t seq = atomic_load(&header->released.seq);
+		atomic_fetch_add(&header->released.waiters, 1);
+		int ret = 0;
+		if (header->size - (tail - atomic_load(&header->head)) < total)
+			ret = _s_shm_event_wait(&header->released, seq,
+				deadline);
+		atomic_fetch_sub(&header->released.waiters, 1);
+		if (ret < 0)
+			return ret;
+	}
+
+	uint64_t offset = tail & mask;
+	queue->wrap = UINT64_MAX;
+	if (need > contiguous) {
+		queue->wrap = offset;
+		offset = 0;
+	}
+
+	struct _s_shm_record *record = (void *)(queue->ring + offset);
+	record->len = len;
+	queue->reserved = total;
+	*data = record + 1;
+	return 0;
+}
+
+int s_shm_queue_commit(struct s_shm_queue *queue)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(queue->reserved, -EINVAL);
+
+	struct _s_shm_header *header = queue->header;
+	if (queue->wrap != UINT64_MAX) {
+		struct _s_shm_record *record = (void *)(queue->ring +
+			queue->wrap);
+		record->len = _S_SHM_QUEUE_WRAP;
+	}
+
+	atomic_store_explicit(&header->tail, atomic_load_explicit(&header->tail,
+		memory_order_relaxed) + queue->reserved, memory_order_release);
+	queue->reserved = 0;
+	_s_shm_event_signal(&header->committed);
+	return 0;
+}
+
+int s_shm_queue_peek(struct s_shm_queue *queue, void **data, int32_t timeout)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(data, -EINVAL);
+
+	struct _s_shm_header *header = queue->header;
+	uint64_t mask = header->size - 1;
+	uint64_t head = atomic_load_explicit(&header->head,
+		memory_order_relaxed);
+	int64_t deadline = (timeout > 0) ? _s_shm_queue_now() + timeout : -1;
+
+	while (atomic_load(&header->tail) == head) {
+		if (!timeout)
+			return -EAGAIN;
+
+		uint32_t seq = atomic_load(&header->committed.seq);
+		atomic_fetch_add(&header->committed.waiters, 1);
+		int ret = 0;
+		if (atomic_load(&header->tail) == head)
+			ret = _s_shm_event_wait(&header->committed, seq,
+				deadline);
+		atomic_fetch_sub(&header->committed.waiters, 1);
+		if (ret < 0)
+			return ret;
+	}
+
+	uint64_t offset = head & mask;
+	struct _s_shm_record *record = (void *)(queue->ring + offset);
+	queue->peeked = 0;
+	if (record->len == _S_SHM_QUEUE_WRAP) {
+		queue->peeked = header->size - offset;
+		record = (void *)queue->ring;
+	}
+	m_return_val_if_fail(record->len <= s_shm_queue_max_size(queue), -EIO);
+
+	queue->peeked += m_shm_queue_record_size(record->len);
+	*data = record + 1;
+	return (int)record->len;
+}
+
+int s_shm_queue_release(struct s_shm_queue *queue)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(queue->peeked, -EINVAL);
+
+	struct _s_shm_header *header = queue->header;
+	atomic_store_explicit(&header->head, atomic_load_explicit(&header->head,
+		memory_order_relaxed) + queue->peeked, memory_order_release);
+	queue->peeked = 0;
+	_s_shm_event_signal(&header->released);
+	return 0;
+}
+
+int s_shm_queue_push(struct s_shm_queue *queue, const void *data,
+	uint32_t len, int32_t timeout)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(data || !len, -EINVAL);
+
+	void *slot = NULL;
+	int ret = s_shm_queue_reserve(queue, len, &slot, timeout);
+	if (ret < 0)
+		return ret;
+
+	memcpy(slot, data, len);
+	return s_shm_queue_commit(queue);
+}
+
+int s_shm_queue_pop(struct s_shm_queue *queue, void *data, uint32_t len,
+	int32_t timeout)
+{
+	m_return_val_if_fail(queue, -EINVAL);
+	m_return_val_if_fail(data || !len, -EINVAL);
+
+	void *slot = NULL;
+	int ret = s_shm_queue_peek(queue, &slot, timeout);
+	if (ret < 0)
+		return ret;
+	if ((uint32_t)ret > len) {
+		queue->peeked = 0;
+		return -EMSGSIZE;
+	}
+
+	memcpy(data, slot, ret);
+	s_shm_queue_release(queue);
+	return ret;
+}
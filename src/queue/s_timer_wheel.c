@@ -0,0 +1,324 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_timer_wheel.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * Each level has 64 slots, a slot of level L covers 64^L ticks. Timers
+ * further than 64^LEVELS ticks are parked in the last slot reachable and
+ * placed again when that slot is cascaded.
+ */
+#define _S_TIMER_WHEEL_BITS 6
+#define _S_TIMER_WHEEL_SLOTS (1U << _S_TIMER_WHEEL_BITS)
+#define _S_TIMER_WHEEL_MASK (_S_TIMER_WHEEL_SLOTS - 1)
+#define _S_TIMER_WHEEL_LEVELS 5
+#define _S_TIMER_WHEEL_RANGE (1ULL << (_S_TIMER_WHEEL_BITS * \
+	_S_TIMER_WHEEL_LEVELS))
+
+/**
+ * @brief The timer structure
+ * @param prev: previous timer of the slot
+ * @param next: next timer of the slot (or of the free list)
+ * @param expire: expiration time
+ * @param data: user data
+ * @param level: level of the slot holding the timer
+ * @param slot: slot holding the timer
+ */
+struct s_timer {
+	struct s_timer *prev;
+	struct s_timer *next;
+	uint64_t expire;
+	void *data;
+	uint8_t level;
+	uint8_t slot;
+};
+
+/**
+ * @brief The timing wheel structure
+ * @param now: current time
+ * @param size: number of pending timers
+ * @param bitmap: non empty slots of each level
+ * @param slots: timer lists
+ * @param free: recycled timers
+ */
+struct s_timer_wheel {
+	uint64_t now;
+	uint32_t size;
+	uint64_t bitmap[_S_TIMER_WHEEL_LEVELS];
+	struct s_timer *slots[_S_TIMER_WHEEL_LEVELS][_S_TIMER_WHEEL_SLOTS];
+	struct s_timer *free;
+};
+
+/**
+ * @brief Convenience macro to get the slot of a time at a level
+ */
+#define m_timer_wheel_slot(time, level) \
+	(((time) >> (_S_TIMER_WHEEL_BITS * (level))) & _S_TIMER_WHEEL_MASK)
+
+/**
+ * @brief Insert a timer in the slot matching its expiration time
+ * @param wheel[in] : wheel to modify
+ * @param timer[in] : timer to insert, expire >= now
+ */
+static void _s_timer_wheel_place(struct s_timer_wheel *wheel,
+	struct s_timer *timer)
+{
+	uint64_t expire = timer->expire;
+	uint64_t delta = expire - wheel->now;
+	uint8_t level = 0;
+
+	if (delta >= _S_TIMER_WHEEL_RANGE) {
+		expire = wheel->now + _S_TIMER_WHEEL_RANGE - 1;
+		delta = _S_TIMER_WHEEL_RANGE - 1;
+	}
+	while (delta >> (_S_TIMER_WHEEL_BITS * (level + 1)))
+		level++;
+
+	uint8_t slot = m_timer_wheel_slot(expire, level);
+	timer->level = level;
+	timer->slot = slot;
+	timer->prev = NULL;
+	timer->next = wheel->slots[level][slot];
+	if (timer->next)
+		timer->next->prev = timer;
+	wheel->slots[level][slot] = timer;
+	wheel->bitmap[level] |= 1ULL << slot;
+}
+
+/**
+ * @brief Remove a timer from its slot
+ * @param wheel[in] : wheel to modify
+ * @param timer[in] : timer to remove
+ */
+static void _s_timer_wheel_unlink(struct s_timer_wheel *wheel,
+	struct s_timer *timer)
+{
+	if (timer->prev)
+		timer->prev->next = timer->next;
+	else
+		wheel->slots[timer->level][timer->slot] = timer->next;
+	if (timer->next)
+		timer->next->prev = timer->prev;
+	if (!wheel->slots[timer->level][timer->slot])
+		wheel->bitmap[timer->level] &= ~(1ULL << timer->slot);
+}
+
+/**
+ * @brief Give a timer back to the free list
+ * @param wheel[in] : wheel to modify
+ * @param timer[in] : timer unlinked
+ */
+static void _s_timer_wheel_recycle(struct s_timer_wheel *wheel,
+	struct s_timer *timer)
+{
+	timer->data = NULL;
+	timer->next = wheel->free;
+	wheel->free = timer;
+}
+
+/**
+ * @brief Rotate right a slot bitmap
+ */
+static uint64_t _s_timer_wheel_rotate(uint64_t bitmap, uint32_t shift)
+{
+	shift &= _S_TIMER_WHEEL_MASK;
+	return (shift) ? (bitmap >> shift) | (bitmap << (64 - shift)) : bitmap;
+}
+
+/**
+ * @brief Get the next tick where a slot must be expired or cascaded
+ * @param wheel[in] : wheel to investigate
+ * @return a time, UINT64_MAX if nothing is pending
+ */
+static uint64_t _s_timer_wheel_next(const struct s_timer_wheel *wheel)
+{
+	uint64_t next = UINT64_MAX;
+
+	/* level 0 holds timers expiring in ]now, now + 64[ */
+	if (wheel->bitmap[0]) {
+		uint64_t rot = _s_timer_wheel_rotate(wheel->bitmap[0],
+			wheel->now + 1);
+		next = wheel->now + 1 + __builtin_ctzll(rot);
+	}
+
+	/* the upper levels are cascaded at the beginning of their slot */
+	for (uint8_t level = 1; level < _S_TIMER_WHEEL_LEVELS; level++) {
+		if (!wheel->bitmap[level])
+			continue;
+		uint32_t shift = _S_TIMER_WHEEL_BITS * level;
+		uint64_t block = wheel->now >> shift;
+		uint64_t rot = _s_timer_wheel_rotate(wheel->bitmap[level],
+			block + 1);
+		uint64_t tick = (block + 1 + __builtin_ctzll(rot)) << shift;
+		next = m_min(next, tick);
+	}
+	return next;
+}
+
+/**
+ * @brief Spread the timers of the upper slots reached by now into the lower
+ * levels. An upper level is reached only when all the levels below are back
+ * to their slot 0.
+ * @param wheel[in] : wheel to modify
+ */
+static void _s_timer_wheel_cascade(struct s_timer_wheel *wheel)
+{
+	for (uint8_t level = 1; level < _S_TIMER_WHEEL_LEVELS; level++) {
+		uint8_t slot = m_timer_wheel_slot(wheel->now, level);
+		struct s_timer *timer = wheel->slots[level][slot];
+
+		wheel->slots[level][slot] = NULL;
+		wheel->bitmap[level] &= ~(1ULL << slot);
+		while (timer) {
+			struct s_timer *next = timer->next;
+			_s_timer_wheel_place(wheel, timer);
+			timer = next;
+		}
+		if (slot)
+			break;
+	}
+}
+
+struct s_timer_wheel *s_timer_wheel_new(uint64_t now)
+{
+	struct s_timer_wheel *wheel = _malloc(sizeof(struct s_timer_wheel));
+	wheel->now = now;
+	return wheel;
+}
+
+/**
+ * @brief Release all the timers of a wheel
+ * @param wheel[in] : wheel to clean
+ * @param func[in] : optional delete function for the pending user data
+ */
+static void _s_timer_wheel_clean(struct s_timer_wheel *wheel,
+	t_destroy_func func)
+{
+	for (uint8_t level = 0; level < _S_TIMER_WHEEL_LEVELS; level++) {
+		for (uint32_t slot = 0; slot < _S_TIMER_WHEEL_SLOTS; slot++) {
+			struct s_timer *timer = wheel->slots[level][slot];
+			while (timer) {
+				struct s_timer *next = timer->next;
+				if (func)
+					func(timer->data);
+				_free(timer);
+				timer = next;
+			}
+		}
+	}
+
+	while (wheel->free) {
+		struct s_timer *next = wheel->free->next;
+		_free(wheel->free);
+		wheel->free = next;
+	}
+}
+
+void s_timer_wheel_delete(struct s_timer_wheel *wheel)
+{
+	m_return_if_fail(wheel);
+
+	_s_timer_wheel_clean(wheel, NULL);
+	_free(wheel);
+}
+
+void s_timer_wheel_delete_full(struct s_timer_wheel *wheel,
+	t_destroy_func func)
+{
+	m_return_if_fail(wheel);
+	m_return_if_fail(func);
+
+	_s_timer_wheel_clean(wheel, func);
+	_free(wheel);
+}
+
+uint8_t s_timer_wheel_empty(const struct s_timer_wheel *wheel)
+{
+	m_return_val_if_fail(wheel, 1);
+
+	return wheel->size == 0;
+}
+
+uint64_t s_timer_wheel_now(const struct s_timer_wheel *wheel)
+{
+	m_return_val_if_fail(wheel, 0);
+
+	return wheel->now;
+}
+
+struct s_timer *s_timer_wheel_schedule(struct s_timer_wheel *wheel,
+	uint64_t expire, void *data)
+{
+	m_return_val_if_fail(wheel, NULL);
+
+	struct s_timer *timer = wheel->free;
+	if (timer)
+		wheel->free = timer->next;
+	else
+		timer = _malloc(sizeof(struct s_timer));
+
+	timer->expire = m_max(expire, wheel->now + 1);
+	timer->data = data;
+	_s_timer_wheel_place(wheel, timer);
+	wheel->size++;
+	return timer;
+}
+
+void *s_timer_wheel_cancel(struct s_timer_wheel *wheel, struct s_timer *timer)
+{
+	m_return_val_if_fail(wheel, NULL);
+	m_return_val_if_fail(timer, NULL);
+
+	void *data = timer->data;
+	_s_timer_wheel_unlink(wheel, timer);
+	_s_timer_wheel_recycle(wheel, timer);
+	wheel->size--;
+	return data;
+}
+
+int s_timer_wheel_advance(struct s_timer_wheel *wheel, uint64_t now,
+	t_foreach_func func, void *user_data)
+{
+	m_return_val_if_fail(wheel, -EINVAL);
+	m_return_val_if_fail(func, -EINVAL);
+
+	int ret = 0;
+	while (wheel->now < now) {
+		uint64_t next = _s_timer_wheel_next(wheel);
+		if (next > now) {
+			wheel->now = now;
+			break;
+		}
+
+		wheel->now = next;
+		if (!m_timer_wheel_slot(next, 0))
+			_s_timer_wheel_cascade(wheel);
+
+		/* callbacks may schedule (after now) or cancel timers */
+		uint8_t slot = m_timer_wheel_slot(next, 0);
+		struct s_timer *timer;
+		while ((timer = wheel->slots[0][slot])) {
+			void *data = timer->data;
+			_s_timer_wheel_unlink(wheel, timer);
+			_s_timer_wheel_recycle(wheel, timer);
+			wheel->size--;
+			ret |= func(data, user_data);
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,166 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "queue/s_top_k.h"
+#include "queue/s_heap-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Number of children per heap element
+ */
+#define _S_TOP_K_ARITY 4
+
+/**
+ * @brief The top-K collector structure
+ * @param ordering: ordering of the elements kept
+ * @param reverse: heap ordering, the worst element kept is the head
+ * @param k: number of elements kept at most
+ * @param size: number of elements kept
+ * @param heap: heap storage
+ */
+struct s_top_k {
+	enum e_ordered ordering;
+	enum e_ordered reverse;
+	uint32_t k;
+	uint32_t size;
+	void **heap;
+};
+
+struct s_top_k *s_top_k_new(enum e_ordered ordering, uint32_t k)
+{
+	m_return_val_if_fail(k > 0, NULL);
+
+	struct s_top_k *top = _malloc(sizeof(struct s_top_k));
+	top->ordering = ordering;
+	top->reverse = (ordering == e_ordered_increase) ?
+		e_ordered_decrease : e_ordered_increase;
+	top->k = k;
+	top->heap = _calloc(sizeof(void *), k);
+	return top;
+}
+
+void s_top_k_delete(struct s_top_k *top)
+{
+	m_return_if_fail(top);
+
+	_free(top->heap);
+	_free(top);
+}
+
+void s_top_k_delete_full(struct s_top_k *top, t_destroy_func func)
+{
+	m_return_if_fail(top);
+	m_return_if_fail(func);
+
+	for (uint32_t i = 0; i < top->size; i++)
+		func(top->heap[i]);
+	s_top_k_delete(top);
+}
+
+uint32_t s_top_k_size(const struct s_top_k *top)
+{
+	m_return_val_if_fail(top, 0);
+
+	return top->size;
+}
+
+void *s_top_k_threshold(const struct s_top_k *top)
+{
+	m_return_val_if_fail(top, NULL);
+
+	return (top->size) ? top->heap[0] : NULL;
+}
+
+void *s_top_k_offer(struct s_top_k *top, t_compare_func cmp, void *data)
+{
+	m_return_val_if_fail(top, NULL);
+	m_return_val_if_fail(cmp, NULL);
+
+	if (top->size < top->k) {
+		top->heap[top->size] = data;
+		_s_heap_sift_up(top->heap, top->size, _S_TOP_K_ARITY,
+			top->reverse, cmp);
+		top->size++;
+		return NULL;
+	}
+
+	/* fast path: not better than the threshold */
+	if (!m_heap_before(top->ordering, cmp, data, top->heap[0]))
+		return data;
+
+	void *evicted = top->heap[0];
+	top->heap[0] = data;
+	_s_heap_sift_down(top->heap, top->size, 0, _S_TOP_K_ARITY,
+		top->reverse, cmp);
+	return evicted;
+}
+
+int s_top_k_offer_n(struct s_top_k *top, t_compare_func cmp, void **data,
+	uint32_t size, t_destroy_func func)
+{
+	m_return_val_if_fail(top, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(data || !size, -EINVAL);
+
+	uint32_t i = 0;
+	int out = 0;
+
+	/* fill the heap in one go while there is room */
+	if (top->size < top->k) {
+		uint32_t fill = m_min(size, top->k - top->size);
+		for (; i < fill; i++)
+			top->heap[top->size + i] = data[i];
+		top->size += fill;
+		_s_heap_make(top->heap, top->size, _S_TOP_K_ARITY,
+			top->reverse, cmp);
+	}
+
+	for (; i < size; i++) {
+		void *threshold = top->heap[0];
+		if (!m_heap_before(top->ordering, cmp, data[i], threshold)) {
+			threshold = data[i];
+		} else {
+			top->heap[0] = data[i];
+			_s_heap_sift_down(top->heap, top->size, 0,
+				_S_TOP_K_ARITY, top->reverse, cmp);
+		}
+		if (func)
+			func(threshold);
+		out++;
+	}
+	return out;
+}
+
+int s_top_k_drain(struct s_top_k *top, t_compare_func cmp, void **data)
+{
+	m_return_val_if_fail(top, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(data || !top->size, -EINVAL);
+
+	/* the head is the worst element: fill the array from its end */
+	int ret = top->size;
+	while (top->size > 0) {
+		data[top->size - 1] = top->heap[0];
+		top->size--;
+		if (top->size > 0) {
+			top->heap[0] = top->heap[top->size];
+			_s_heap_sift_down(top->heap, top->size, 0,
+				_S_TOP_K_ARITY, top->reverse, cmp);
+		}
+	}
+	return ret;
+}
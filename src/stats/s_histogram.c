@@ -0,0 +1,226 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <stdatomic.h>
+#include "stats/s_histogram.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * Layout: values below 2^(SUB_BITS + 1) have their own bucket, then each
+ * power of 2 is split into 2^SUB_BITS linear sub-buckets.
+ */
+#define _S_HISTOGRAM_SUB_BITS 5
+#define _S_HISTOGRAM_SUB (1U << _S_HISTOGRAM_SUB_BITS)
+#define _S_HISTOGRAM_LINEAR (_S_HISTOGRAM_SUB << 1)
+#define _S_HISTOGRAM_MAX_BITS 40
+#define _S_HISTOGRAM_MAX ((1ULL << _S_HISTOGRAM_MAX_BITS) - 1)
+#define _S_HISTOGRAM_BUCKETS (_S_HISTOGRAM_LINEAR + _S_HISTOGRAM_SUB * \
+	(_S_HISTOGRAM_MAX_BITS - _S_HISTOGRAM_SUB_BITS - 1))
+
+/**
+ * @brief The histogram structure
+ * @param count: number of values recorded
+ * @param sum: sum of the values recorded
+ * @param min: smallest value recorded
+ * @param max: biggest value recorded
+ * @param buckets: number of values per bucket
+ */
+struct s_histogram {
+	_Atomic uint64_t count;
+	_Atomic uint64_t sum;
+	_Atomic uint64_t min;
+	_Atomic uint64_t max;
+	_Atomic uint64_t buckets[_S_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * @brief Get the bucket of a value
+ * @param value[in] : value already saturated
+ * @return a bucket index
+ */
+static uint32_t _s_histogram_index(uint64_t value)
+{
+	if (value < _S_HISTOGRAM_LINEAR)
+		return (uint32_t)value;
+
+	uint32_t msb = 63 - __builtin_clzll(value);
+	uint32_t shift = msb - _S_HISTOGRAM_SUB_BITS;
+	uint32_t sub = (uint32_t)(value >> shift) - _S_HISTOGRAM_SUB;
+	return _S_HISTOGRAM_LINEAR + (shift - 1) * _S_HISTOGRAM_SUB + sub;
+}
+
+/**
+ * @brief Get the value represented by a bucket (middle of its range)
+ * @param index[in] : bucket index
+ * @return a value
+ */
+static uint64_t _s_histogram_value(uint32_t index)
+{
+	if (index < _S_HISTOGRAM_LINEAR)
+		return index;
+
+	uint32_t shift = (index - _S_HISTOGRAM_LINEAR) / _S_HISTOGRAM_SUB + 1;
+	uint64_t sub = (index - _S_HISTOGRAM_LINEAR) % _S_HISTOGRAM_SUB;
+	uint64_t lower = (_S_HISTOGRAM_SUB + sub) << shift;
+	return lower + ((1ULL << shift) >> 1);
+}
+
+/**
+ * @brief Lower the minimum (or raise the maximum) of the histogram
+ * @param extremum[in] : min or max field
+ * @param value[in] : value recorded
+ * @param lower[in] : 1 for the min, 0 for the max
+ */
+static void _s_histogram_extremum(_Atomic uint64_t *extremum, uint64_t value,
+	uint8_t lower)
+{
+	uint64_t cur = atomic_load_explicit(extremum, memory_order_relaxed);
+
+	while ((lower) ? value < cur : value > cur) {
+		if (atomic_compare_exchange_weak_explicit(extremum, &cur, value,
+				memory_order_relaxed, memory_order_relaxed))
+			break;
+	}
+}
+
+struct s_histogram *s_histogram_new(void)
+{
+	struct s_histogram *histogram = _malloc(sizeof(struct s_histogram));
+	atomic_init(&histogram->min, UINT64_MAX);
+	return histogram;
+}
+
+void s_histogram_delete(struct s_histogram *histogram)
+{
+	m_return_if_fail(histogram);
+
+	_free(histogram);
+}
+
+void s_histogram_reset(struct s_histogram *histogram)
+{
+	m_return_if_fail(histogram);
+
+	for (uint32_t i = 0; i < _S_HISTOGRAM_BUCKETS; i++)
+		atomic_store_explicit(&histogram->buckets[i], 0,
+			memory_order_relaxed);
+	atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->sum, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->min, UINT64_MAX,
+		memory_order_relaxed);
+	atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+}
+
+int s_histogram_record(struct s_histogram *histogram, uint64_t value)
+{
+	m_return_val_if_fail(histogram, -EINVAL);
+
+	value = m_min(value, _S_HISTOGRAM_MAX);
+	atomic_fetch_add_explicit(&histogram->buckets[
+		_s_histogram_index(value)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+	_s_histogram_extremum(&histogram->min, value, 1);
+	_s_histogram_extremum(&histogram->max, value, 0);
+	return 0;
+}
+
+int s_histogram_merge(struct s_histogram *dst, const struct s_histogram *src)
+{
+	m_return_val_if_fail(dst, -EINVAL);
+	m_return_val_if_fail(src, -EINVAL);
+
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < _S_HISTOGRAM_BUCKETS; i++) {
+		uint64_t nb = atomic_load_explicit(&src->buckets[i],
+			memory_order_relaxed);
+		if (nb) {
+			atomic_fetch_add_explicit(&dst->buckets[i], nb,
+				memory_order_relaxed);
+			count += nb;
+		}
+	}
+	/* keep count consistent with the buckets actually merged */
+	atomic_fetch_add_explicit(&dst->count, count, memory_order_relaxed);
+	atomic_fetch_add_explicit(&dst->sum, atomic_load_explicit(&src->sum,
+		memory_order_relaxed), memory_order_relaxed);
+	_s_histogram_extremum(&dst->min, atomic_load_explicit(&src->min,
+		memory_order_relaxed), 1);
+	_s_histogram_extremum(&dst->max, atomic_load_explicit(&src->max,
+		memory_order_relaxed), 0);
+	return 0;
+}
+
+uint64_t s_histogram_count(const struct s_histogram *histogram)
+{
+	m_return_val_if_fail(histogram, 0);
+
+	return atomic_load_explicit(&histogram->count, memory_order_relaxed);
+}
+
+uint64_t s_histogram_min(const struct s_histogram *histogram)
+{
+	m_return_val_if_fail(histogram, 0);
+
+	uint64_t min = atomic_load_explicit(&histogram->min,
+		memory_order_relaxed);
+	return (min == UINT64_MAX) ? 0 : min;
+}
+
+uint64_t s_histogram_max(const struct s_histogram *histogram)
+{
+	m_return_val_if_fail(histogram, 0);
+
+	return atomic_load_explicit(&histogram->max, memory_order_relaxed);
+}
+
+double s_histogram_mean(const struct s_histogram *histogram)
+{
+	m_return_val_if_fail(histogram, 0);
+
+	uint64_t count = s_histogram_count(histogram);
+	if (!count)
+		return 0;
+	return (double)atomic_load_explicit(&histogram->sum,
+		memory_order_relaxed) / count;
+}
+
+uint64_t s_histogram_percentile(const struct s_histogram *histogram,
+	double percentile)
+{
+	m_return_val_if_fail(histogram, 0);
+	m_return_val_if_fail(percentile >= 0 && percentile <= 100, 0);
+
+	uint64_t count = s_histogram_count(histogram);
+	if (!count)
+		return 0;
+
+	uint64_t rank = (uint64_t)(percentile * count / 100 + 0.5);
+	rank = m_max(rank, 1ULL);
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < _S_HISTOGRAM_BUCKETS; i++) {
+		seen += atomic_load_explicit(&histogram->buckets[i],
+			memory_order_relaxed);
+		if (seen >= rank) {
+			uint64_t value = _s_histogram_value(i);
+			value = m_max(value, s_histogram_min(histogram));
+			return m_min(value, s_histogram_max(histogram));
+		}
+	}
+	return s_histogram_max(histogram);
+}
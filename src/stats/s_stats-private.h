@@ -0,0 +1,65 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#ifndef _TOOLS_S_STATS_PRIVATE_H_
+# define _TOOLS_S_STATS_PRIVATE_H_
+
+# include "stats/s_stats.h"
+
+# ifdef TOOLS_STATS
+
+/**
+ * @brief A timed scope
+ * @param op: operation timed
+ * @param start: timestamp at the beginning of the scope
+ */
+struct _s_stats_scope {
+	enum e_stats_op op;
+	uint64_t start;
+};
+
+/**
+ * @brief Get a monotonic timestamp
+ * @return a timestamp in nanoseconds
+ */
+uint64_t _s_stats_now(void);
+
+/**
+ * @brief Record the latency of a scope into the histogram of the calling
+ * thread
+ * @param scope[in] : scope leaving
+ */
+void _s_stats_scope_end(struct _s_stats_scope *scope);
+
+/**
+ * @brief Time the enclosing scope until it is left, whatever the return path
+ * @param op[in] : operation timed
+ */
+#  define m_stats_scope(op) \
+	struct _s_stats_scope _stats_scope \
+		__attribute__((cleanup(_s_stats_scope_end))) = { \
+			(op), _s_stats_now() \
+		}
+
+# else
+
+#  define m_stats_scope(op) \
+	do { \
+	} while (0)
+
+# endif /* !TOOLS_STATS */
+
+#endif /* !_TOOLS_S_STATS_PRIVATE_H_ */
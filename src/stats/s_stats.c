@@ -0,0 +1,249 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Printable names, indexed by enum e_stats_op
+ */
+static const char *_s_stats_names[e_stats_op_max] = {
+	"s_stack_push",
+	"s_stack_pop",
+	"s_queue_push",
+	"s_queue_pop",
+	"s_ordered_queue_push",
+	"s_ordered_queue_pop",
+	"s_ordered_queue_push_n",
+	"s_ws_deque_push",
+	"s_ws_deque_pop",
+	"s_ws_deque_steal",
+	"s_bs_tree_add",
+	"s_bs_tree_remove",
+	"s_bs_tree_exist",
+	"s_bs_tree_foreach",
+	"s_rb_tree_add",
+	"s_rb_tree_remove",
+	"s_rb_tree_exist",
+	"s_rb_tree_foreach",
+	"s_list_push",
+	"s_list_pop",
+	"s_list_foreach",
+	"s_d_list_push",
+	"s_d_list_pop",
+	"s_d_list_foreach",
+	"s_bp_tree_add",
+	"s_bp_tree_remove",
+	"s_bp_tree_exist",
+	"s_bp_tree_foreach",
+	"s_rb_map_add",
+	"s_rb_map_remove",
+	"s_rb_map_exist",
+	"s_rb_map_foreach",
+	"s_skip_map_add",
+	"s_skip_map_remove",
+	"s_skip_map_exist",
+	"s_skip_map_foreach",
+	"s_rb_compact_add",
+	"s_rb_compact_remove",
+	"s_rb_compact_exist",
+	"s_rb_compact_foreach",
+	"s_indexed_queue_push",
+	"s_indexed_queue_pop",
+	"s_minmax_queue_push",
+	"s_minmax_queue_pop",
+	"s_pairing_queue_push",
+	"s_pairing_queue_pop",
+	"s_radix_queue_push",
+	"s_radix_queue_pop",
+	"s_multi_queue_push",
+	"s_multi_queue_pop"
+};
+
+const char *s_stats_name(enum e_stats_op op)
+{
+	m_return_val_if_fail(op < e_stats_op_max, NULL);
+
+	return _s_stats_names[op];
+}
+
+#ifdef TOOLS_STATS
+
+/**
+ * @brief Histograms recorded by one thread. Blocks are never released: when
+ * a thread exits its block is left to the next new thread, which keep
+ * accumulating into it.
+ * @param used: set while a thread own the block
+ * @param next: next block of the registry
+ * @param histograms: per operation histograms, allocated on first record
+ */
+struct _s_stats_block {
+	atomic_bool used;
+	struct _s_stats_block *next;
+	_Atomic(struct s_histogram *) histograms[e_stats_op_max];
+};
+
+/**
+ * @brief Lock-free registry of all the blocks (push only)
+ */
+static _Atomic(struct _s_stats_block *) _s_stats_registry;
+
+/**
+ * @brief Block of the calling thread
+ */
+static __thread struct _s_stats_block *_s_stats_local;
+
+/**
+ * @brief Key used to release the block when a thread exits
+ */
+static pthread_key_t _s_stats_key;
+static pthread_once_t _s_stats_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Give back the block of an exiting thread
+ * @param data[in] : the block
+ */
+static void _s_stats_release(void *data)
+{
+	struct _s_stats_block *block = data;
+	atomic_store_explicit(&block->used, 0, memory_order_release);
+}
+
+/**
+ * @brief Create the thread exit key
+ */
+static void _s_stats_init(void)
+{
+	pthread_key_create(&_s_stats_key, _s_stats_release);
+}
+
+/**
+ * @brief Get the block of the calling thread, reusing a released one if any
+ * @return a valid pointer
+ */
+static struct _s_stats_block *_s_stats_block(void)
+{
+	if (_s_stats_local)
+		return _s_stats_local;
+
+	pthread_once(&_s_stats_once, _s_stats_init);
+
+	struct _s_stats_block *block = atomic_load_explicit(&_s_stats_registry,
+		memory_order_acquire);
+	for (; block; block = block->next) {
+		bool used = 0;
+		if (atomic_compare_exchange_strong(&block->used, &used, 1))
+			break;
+	}
+
+	if (!block) {
+		block = _malloc(sizeof(struct _s_stats_block));
+		atomic_init(&block->used, 1);
+		block->next = atomic_load(&_s_stats_registry);
+		while (!atomic_compare_exchange_weak(&_s_stats_registry,
+				&block->next, block))
+			;
+	}
+
+	pthread_setspecific(_s_stats_key, block);
+	_s_stats_local = block;
+	return block;
+}
+
+uint64_t _s_stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void _s_stats_scope_end(struct _s_stats_scope *scope)
+{
+	uint64_t latency = _s_stats_now() - scope->start;
+	struct _s_stats_block *block = _s_stats_block();
+	struct s_histogram *histogram = atomic_load_explicit(
+		&block->histograms[scope->op], memory_order_relaxed);
+
+	if (!histogram) {
+		histogram = s_histogram_new();
+		atomic_store_explicit(&block->histograms[scope->op], histogram,
+			memory_order_release);
+	}
+	s_histogram_record(histogram, latency);
+}
+
+uint8_t s_stats_enabled(void)
+{
+	return 1;
+}
+
+struct s_histogram *s_stats_snapshot(enum e_stats_op op)
+{
+	m_return_val_if_fail(op < e_stats_op_max, NULL);
+
+	struct s_histogram *snapshot = s_histogram_new();
+	struct _s_stats_block *block = atomic_load_explicit(&_s_stats_registry,
+		memory_order_acquire);
+
+	for (; block; block = block->next) {
+		struct s_histogram *histogram = atomic_load_explicit(
+			&block->histograms[op], memory_order_acquire);
+		if (histogram)
+			s_histogram_merge(snapshot, histogram);
+	}
+	return snapshot;
+}
+
+void s_stats_reset(void)
+{
+	struct _s_stats_block *block = atomic_load_explicit(&_s_stats_registry,
+		memory_order_acquire);
+
+	for (; block; block = block->next) {
+		for (uint32_t op = 0; op < e_stats_op_max; op++) {
+			struct s_histogram *histogram = atomic_load_explicit(
+				&block->histograms[op], memory_order_acquire);
+			if (histogram)
+				s_histogram_reset(histogram);
+		}
+	}
+}
+
+#else
+
+uint8_t s_stats_enabled(void)
+{
+	return 0;
+}
+
+struct s_histogram *s_stats_snapshot(enum e_stats_op op)
+{
+	m_return_val_if_fail(op < e_stats_op_max, NULL);
+
+	return NULL;
+}
+
+void s_stats_reset(void)
+{
+}
+
+#endif /* !TOOLS_STATS */
@@ -0,0 +1,403 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "list/s_ws_deque.h"
+#include "queue/s_queue.h"
+#include "thread/s_executor.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Number of failed lookups before an idle worker goes to sleep
+ */
+#define _S_EXECUTOR_SPIN 64
+
+/**
+ * @brief A task waiting to be run
+ * @param func: task function
+ * @param data: user data pass through the task function
+ * @param group: optional wait group to notify
+ */
+struct _s_task {
+	t_task_func func;
+	void *data;
+	struct s_wait_group *group;
+};
+
+/**
+ * @brief The wait group structure
+ * @param pending: number of tasks not finished yet
+ * @param result: bitwise or of the task results
+ * @param lock: protect the wake up of the external waiters
+ * @param cond: signaled when pending reach 0
+ */
+struct s_wait_group {
+	_Atomic uint32_t pending;
+	atomic_int result;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+/**
+ * @brief A worker of the executor
+ * @param executor: executor owning the worker
+ * @param deque: local tasks, stolen by the other workers
+ * @param thread: worker thread
+ * @param seed: state of the victim random generator
+ */
+struct _s_worker {
+	struct s_executor *executor;
+	struct s_ws_deque *deque;
+	pthread_t thread;
+	uint64_t seed;
+};
+
+/**
+ * @brief The executor structure
+ * @param size: number of workers
+ * @param workers: workers array
+ * @param lock: protect injected and the sleep of the workers
+ * @param cond: signaled when a task is available or on shutdown
+ * @param injected: tasks submitted from outside the executor
+ * @param pending: number of tasks queued but not taken yet
+ * @param sleeping: number of workers waiting on cond
+ * @param shutdown: set when the executor is being deleted
+ */
+struct s_executor {
+	uint32_t size;
+	struct _s_worker *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct s_queue *injected;
+	_Atomic uint64_t pending;
+	_Atomic uint32_t sleeping;
+	atomic_bool shutdown;
+};
+
+/**
+ * @brief Worker of the calling thread, NULL outside of the executors
+ */
+static __thread struct _s_worker *_s_current;
+
+/**
+ * @brief Get the worker of the calling thread for an executor
+ * @param executor[in] : executor to check
+ * @return a valid pointer if the caller is one of its workers, NULL otherwise
+ */
+static struct _s_worker *_s_executor_self(struct s_executor *executor)
+{
+	return (_s_current && _s_current->executor == executor) ?
+		_s_current : NULL;
+}
+
+/**
+ * @brief Pick a random victim (xorshift64)
+ * @param worker[in] : thief
+ * @return an index in the workers array
+ */
+static uint32_t _s_worker_random(struct _s_worker *worker)
+{
+	uint64_t x = worker->seed;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	worker->seed = x;
+	return (uint32_t)(x % worker->executor->size);
+}
+
+/**
+ * @brief Look for a task: local deque first, then injected tasks, then
+ * steal from the other workers starting at a random victim.
+ * @param worker[in] : worker looking for a task
+ * @return a valid task on success, NULL if nothing was found
+ */
+static struct _s_task *_s_worker_find(struct _s_worker *worker)
+{
+	struct s_executor *executor = worker->executor;
+	struct _s_task *task = s_ws_deque_pop(worker->deque);
+
+	if (!task && atomic_load(&executor->pending)) {
+		pthread_mutex_lock(&executor->lock);
+		task = s_queue_pop(executor->injected);
+		pthread_mutex_unlock(&executor->lock);
+	}
+
+	if (!task && executor->size > 1) {
+		uint32_t start = _s_worker_random(worker);
+		for (uint32_t i = 0; !task && i < executor->size; i++) {
+			struct _s_worker *victim = &executor->workers[
+				(start + i) % executor->size];
+			if (victim != worker)
+				task = s_ws_deque_steal(victim->deque);
+		}
+	}
+
+	if (task)
+		atomic_fetch_sub(&executor->pending, 1);
+	return task;
+}
+
+/**
+ * @brief Run a task, notify its wait group and release it
+ * @param task[in] : task to run
+ */
+static void _s_task_run(struct _s_task *task)
+{
+	struct s_wait_group *group = task->group;
+	int ret = task->func(task->data);
+
+	_free(task);
+	if (group) {
+		atomic_fetch_or(&group->result, ret);
+		pthread_mutex_lock(&group->lock);
+		if (atomic_fetch_sub(&group->pending, 1) == 1)
+			pthread_cond_broadcast(&group->cond);
+		pthread_mutex_unlock(&group->lock);
+	}
+}
+
+/**
+ * @brief Put the worker to sleep until a task is queued or a shutdown is
+ * requested.
+ * @param executor[in] : executor of the worker
+ */
+static void _s_executor_sleep(struct s_executor *executor)
+{
+	pthread_mutex_lock(&executor->lock);
+	atomic_fetch_add(&executor->sleeping, 1);
+	while (!atomic_load(&executor->pending) &&
+			!atomic_load(&executor->shutdown))
+		pthread_cond_wait(&executor->cond, &executor->lock);
+	atomic_fetch_sub(&executor->sleeping, 1);
+	pthread_mutex_unlock(&executor->lock);
+}
+
+/**
+ * @brief Worker thread main loop
+ * @param data[in] : the worker
+ * @return NULL
+ */
+static void *_s_worker_main(void *data)
+{
+	struct _s_worker *worker = data;
+	struct s_executor *executor = worker->executor;
+	uint32_t idle = 0;
+
+	_s_current = worker;
+	while (1) {
+		struct _s_task *task = _s_worker_find(worker);
+		if (task) {
+			_s_task_run(task);
+			idle = 0;
+		} else if (atomic_load(&executor->shutdown) &&
+				!atomic_load(&executor->pending)) {
+			break;
+		} else if (++idle < _S_EXECUTOR_SPIN) {
+			sched_yield();
+		} else {
+			_s_executor_sleep(executor);
+			idle = 0;
+		}
+	}
+	_s_current = NULL;
+	return NULL;
+}
+
+/**
+ * @brief Queue a task, on the local deque when called from a worker,
+ * into the injected queue otherwise, then wake up a sleeping worker.
+ * @param executor[in] : executor to use
+ * @param task[in] : task to queue
+ * @return 0 on success, -errno on error
+ */
+static int _s_executor_queue(struct s_executor *executor,
+	struct _s_task *task)
+{
+	struct _s_worker *self = _s_executor_self(executor);
+	int ret = 0;
+
+	if (self) {
+		ret = s_ws_deque_push(self->deque, task);
+	} else {
+		pthread_mutex_lock(&executor->lock);
+		ret = s_queue_push(executor->injected, task);
+		pthread_mutex_unlock(&executor->lock);
+	}
+	if (ret < 0)
+		return ret;
+
+	atomic_fetch_add(&executor->pending, 1);
+	if (atomic_load(&executor->sleeping)) {
+		pthread_mutex_lock(&executor->lock);
+		pthread_cond_signal(&executor->cond);
+		pthread_mutex_unlock(&executor->lock);
+	}
+	return 0;
+}
+
+/**
+ * @brief Shutdown the workers then release an executor
+ * @param executor[in] : executor to release
+ * @param started[in] : number of workers running
+ */
+static void _s_executor_stop(struct s_executor *executor, uint32_t started)
+{
+	pthread_mutex_lock(&executor->lock);
+	atomic_store(&executor->shutdown, 1);
+	pthread_cond_broadcast(&executor->cond);
+	pthread_mutex_unlock(&executor->lock);
+
+	for (uint32_t i = 0; i < started; i++)
+		pthread_join(executor->workers[i].thread, NULL);
+	for (uint32_t i = 0; i < executor->size; i++)
+		s_ws_deque_delete(executor->workers[i].deque);
+
+	s_queue_delete(executor->injected);
+	pthread_cond_destroy(&executor->cond);
+	pthread_mutex_destroy(&executor->lock);
+	_free(executor->workers);
+	_free(executor);
+}
+
+struct s_executor *s_executor_new(uint32_t workers)
+{
+	if (!workers) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = (cpus > 0) ? (uint32_t)cpus : 1;
+	}
+
+	struct s_executor *executor = _malloc(sizeof(struct s_executor));
+	executor->workers = _calloc(sizeof(struct _s_worker), workers);
+	executor->injected = s_queue_new();
+	pthread_mutex_init(&executor->lock, NULL);
+	pthread_cond_init(&executor->cond, NULL);
+	atomic_init(&executor->pending, 0);
+	atomic_init(&executor->sleeping, 0);
+	atomic_init(&executor->shutdown, 0);
+
+	executor->size = workers;
+	for (uint32_t i = 0; i < workers; i++) {
+		executor->workers[i].executor = executor;
+		executor->workers[i].deque = s_ws_deque_new();
+		executor->workers[i].seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+	}
+
+	for (uint32_t i = 0; i < workers; i++) {
+		int ret = pthread_create(&executor->workers[i].thread, NULL,
+			_s_worker_main, &executor->workers[i]);
+		if (ret != 0) {
+			m_errno_print(ret);
+			/* the started workers may steal from any deque */
+			_s_executor_stop(executor, i);
+			return NULL;
+		}
+	}
+	return executor;
+}
+
+void s_executor_delete(struct s_executor *executor)
+{
+	m_return_if_fail(executor);
+	m_return_if_fail(!_s_executor_self(executor));
+
+	_s_executor_stop(executor, executor->size);
+}
+
+uint32_t s_executor_workers(const struct s_executor *executor)
+{
+	m_return_val_if_fail(executor, 0);
+
+	return executor->size;
+}
+
+int s_executor_spawn(struct s_executor *executor, struct s_wait_group *group,
+	t_task_func func, void *data)
+{
+	m_return_val_if_fail(executor, -EINVAL);
+	m_return_val_if_fail(func, -EINVAL);
+
+	struct _s_task *task = _malloc(sizeof(struct _s_task));
+	task->func = func;
+	task->data = data;
+	task->group = group;
+
+	if (group)
+		atomic_fetch_add(&group->pending, 1);
+
+	int ret = _s_executor_queue(executor, task);
+	if (ret < 0) {
+		if (group)
+			atomic_fetch_sub(&group->pending, 1);
+		_free(task);
+	}
+	return ret;
+}
+
+int s_executor_submit(struct s_executor *executor, t_task_func func,
+	void *data)
+{
+	return s_executor_spawn(executor, NULL, func, data);
+}
+
+int s_executor_wait(struct s_executor *executor, struct s_wait_group *group)
+{
+	m_return_val_if_fail(executor, -EINVAL);
+	m_return_val_if_fail(group, -EINVAL);
+
+	struct _s_worker *self = _s_executor_self(executor);
+	if (self) {
+		/* help the other workers instead of blocking one of them */
+		while (atomic_load(&group->pending)) {
+			struct _s_task *task = _s_worker_find(self);
+			if (task)
+				_s_task_run(task);
+			else
+				sched_yield();
+		}
+	}
+
+	/* also synchronize with the last notifier before returning */
+	pthread_mutex_lock(&group->lock);
+	while (atomic_load(&group->pending))
+		pthread_cond_wait(&group->cond, &group->lock);
+	pthread_mutex_unlock(&group->lock);
+
+	return atomic_load(&group->result);
+}
+
+struct s_wait_group *s_wait_group_new(void)
+{
+	struct s_wait_group *group = _malloc(sizeof(struct s_wait_group));
+	atomic_init(&group->pending, 0);
+	atomic_init(&group->result, 0);
+	pthread_mutex_init(&group->lock, NULL);
+	pthread_cond_init(&group->cond, NULL);
+	return group;
+}
+
+void s_wait_group_delete(struct s_wait_group *group)
+{
+	m_return_if_fail(group);
+
+	pthread_cond_destroy(&group->cond);
+	pthread_mutex_destroy(&group->lock);
+	_free(group);
+}
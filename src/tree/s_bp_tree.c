@@ -0,0 +1,665 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <string.h>
+#include "tree/s_bp_tree.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * The nodes are 4 cache lines wide: an inner node holds 15 keys and 16
+ * children, a leaf 29 elements plus its links. A node other than the root
+ * is kept at least half full.
+ */
+#define _S_BP_TREE_LINE 64
+#define _S_BP_TREE_KEYS 15
+#define _S_BP_TREE_DATA 29
+#define _S_BP_TREE_KEYS_MIN (_S_BP_TREE_KEYS / 2)
+#define _S_BP_TREE_DATA_MIN (_S_BP_TREE_DATA / 2)
+
+/**
+ * @brief The header shared by all the nodes
+ * @param count: number of keys (inner node) or elements (leaf)
+ * @param leaf: 1 if the node is a leaf
+ */
+struct _s_bp_node {
+	uint16_t count;
+	uint8_t leaf;
+};
+
+/**
+ * @brief An inner node. Each key is the smallest element of the child on its
+ * right, so it always points to an element still into the tree.
+ * @param node: header
+ * @param keys: separators
+ * @param childs: children
+ */
+struct _s_bp_inner {
+	struct _s_bp_node node;
+	void *keys[_S_BP_TREE_KEYS];
+	struct _s_bp_node *childs[_S_BP_TREE_KEYS + 1];
+};
+
+/**
+ * @brief A leaf node
+ * @param node: header
+ * @param prev: previous leaf
+ * @param next: next leaf
+ * @param data: elements, sorted
+ */
+struct _s_bp_leaf {
+	struct _s_bp_node node;
+	struct _s_bp_leaf *prev;
+	struct _s_bp_leaf *next;
+	void *data[_S_BP_TREE_DATA];
+};
+
+_Static_assert(sizeof(struct _s_bp_inner) % _S_BP_TREE_LINE == 0,
+	"inner node must fill whole cache lines");
+_Static_assert(sizeof(struct _s_bp_leaf) % _S_BP_TREE_LINE == 0,
+	"leaf must fill whole cache lines");
+
+/**
+ * @brief The B+tree structure
+ * @param root: root node, NULL if empty
+ * @param first: first leaf
+ * @param last: last leaf
+ * @param size: number of elements
+ */
+struct s_bp_tree {
+	struct _s_bp_node *root;
+	struct _s_bp_leaf *first;
+	struct _s_bp_leaf *last;
+	uint32_t size;
+};
+
+/**
+ * @brief Convenience macros to cast a node
+ */
+#define m_bp_tree_inner(node) ((struct _s_bp_inner *)(node))
+#define m_bp_tree_leaf(node) ((struct _s_bp_leaf *)(node))
+
+/**
+ * @brief Count the items of a sorted array smaller than data, or not bigger
+ * if or_equal
+ */
+static uint16_t _s_bp_tree_search(void **items, uint16_t count,
+	t_compare_func cmp, void *data, uint8_t or_equal)
+{
+	uint16_t lo = 0;
+	uint16_t hi = count;
+
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) / 2;
+		int ret = cmp(items[mid], data);
+		if (ret < 0 || (or_equal && ret == 0))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * @brief Allocate a new node
+ */
+static struct _s_bp_node *_s_bp_tree_node_new(uint8_t leaf)
+{
+	struct _s_bp_node *node = _aligned_malloc(_S_BP_TREE_LINE, (leaf) ?
+		sizeof(struct _s_bp_leaf) : sizeof(struct _s_bp_inner));
+	node->leaf = leaf;
+	return node;
+}
+
+/**
+ * @brief Get the smallest element of a subtree
+ */
+static void *_s_bp_tree_min(struct _s_bp_node *node)
+{
+	while (!node->leaf)
+		node = m_bp_tree_inner(node)->childs[0];
+	return m_bp_tree_leaf(node)->data[0];
+}
+
+struct s_bp_tree *s_bp_tree_new(void)
+{
+	return _malloc(sizeof(struct s_bp_tree));
+}
+
+/**
+ * @brief Release a subtree
+ */
+static void _s_bp_tree_clean(struct _s_bp_node *node, t_destroy_func destroy)
+{
+	if (node->leaf) {
+		for (uint16_t i = 0; destroy && i < node->count; i++)
+			destroy(m_bp_tree_leaf(node)->data[i]);
+	} else {
+		for (uint16_t i = 0; i <= node->count; i++)
+			_s_bp_tree_clean(m_bp_tree_inner(node)->childs[i],
+				destroy);
+	}
+	_free(node);
+}
+
+void s_bp_tree_delete(struct s_bp_tree *tree)
+{
+	m_return_if_fail(tree);
+
+	if (tree->root)
+		_s_bp_tree_clean(tree->root, NULL);
+	_free(tree);
+}
+
+void s_bp_tree_delete_full(struct s_bp_tree *tree, t_destroy_func destroy)
+{
+	m_return_if_fail(tree);
+	m_return_if_fail(destroy);
+
+	if (tree->root)
+		_s_bp_tree_clean(tree->root, destroy);
+	_free(tree);
+}
+
+uint32_t s_bp_tree_size(const struct s_bp_tree *tree)
+{
+	m_return_val_if_fail(tree, 0);
+
+	return tree->size;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * add implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Insert an element into a leaf, splitting it when full
+ * @param tree[in] : tree to modify
+ * @param leaf[in] : leaf to modify
+ * @param cmp[in] : compare element function
+ * @param data[in] : element to insert
+ * @param sep[out] : smallest element of the new leaf
+ * @return the new right leaf, NULL if no split
+ */
+static struct _s_bp_node *_s_bp_tree_leaf_insert(struct s_bp_tree *tree,
+	struct _s_bp_leaf *leaf, t_compare_func cmp, void *data, void **sep)
+{
+	uint16_t count = leaf->node.count;
+	uint16_t pos = _s_bp_tree_search(leaf->data, count, cmp, data, 1);
+
+	if (count < _S_BP_TREE_DATA) {
+		memmove(leaf->data + pos + 1, leaf->data + pos,
+			(count - pos) * sizeof(void *));
+		leaf->data[pos] = data;
+		leaf->node.count++;
+		return NULL;
+	}
+
+	void *items[_S_BP_TREE_DATA + 1];
+	memcpy(items, leaf->data, pos * sizeof(void *));
+	items[pos] = data;
+	memcpy(items + pos + 1, leaf->data + pos, (count - pos) *
+		sizeof(void *));
+
+	struct _s_bp_leaf *right = m_bp_tree_leaf(_s_bp_tree_node_new(1));
+	uint16_t half = (_S_BP_TREE_DATA + 1) / 2;
+
+	memcpy(leaf->data, items, half * sizeof(void *));
+	leaf->node.count = half;
+	memcpy(right->data, items + half, (_S_BP_TREE_DATA + 1 - half) *
+		sizeof(void *));
+	right->node.count = _S_BP_TREE_DATA + 1 - half;
+
+	right->prev = leaf;
+	right->next = leaf->next;
+	if (right->next)
+		right->next->prev = right;
+	else
+		tree->last = right;
+	leaf->next = right;
+
+	*sep = right->data[0];
+	return &right->node;
+}
+
+/**
+ * @brief Insert an element into a subtree, splitting the full nodes on the
+ * way back
+ * @param tree[in] : tree to modify
+ * @param node[in] : subtree to modify
+ * @param cmp[in] : compare element function
+ * @param data[in] : element to insert
+ * @param sep[out] : smallest element of the new node
+ * @return the new right node, NULL if no split
+ */
+static struct _s_bp_node *_s_bp_tree_insert(struct s_bp_tree *tree,
+	struct _s_bp_node *node, t_compare_func cmp, void *data, void **sep)
+{
+	if (node->leaf)
+		return _s_bp_tree_leaf_insert(tree, m_bp_tree_leaf(node), cmp,
+			data, sep);
+
+	struct _s_bp_inner *inner = m_bp_tree_inner(node);
+	uint16_t count = node->count;
+	uint16_t i = _s_bp_tree_search(inner->keys, count, cmp, data, 1);
+	void *key;
+	struct _s_bp_node *child = _s_bp_tree_insert(tree, inner->childs[i],
+		cmp, data, &key);
+
+	if (!child)
+		return NULL;
+
+	if (count < _S_BP_TREE_KEYS) {
+		memmove(inner->keys + i + 1, inner->keys + i, (count - i) *
+			sizeof(void *));
+		memmove(inner->childs + i + 2, inner->childs + i + 1,
+			(count - i) * sizeof(void *));
+		inner->keys[i] = key;
+		inner->childs[i + 1] = child;
+		node->count++;
+		return NULL;
+	}
+
+	void *keys[_S_BP_TREE_KEYS + 1];
+	struct _s_bp_node *childs[_S_BP_TREE_KEYS + 2];
+	memcpy(keys, inner->keys, i * sizeof(void *));
+	keys[i] = key;
+	memcpy(keys + i + 1, inner->keys + i, (count - i) * sizeof(void *));
+	memcpy(childs, inner->childs, (i + 1) * sizeof(void *));
+	childs[i + 1] = child;
+	memcpy(childs + i + 2, inner->childs + i + 1, (count - i) *
+		sizeof(void *));
+
+	/* the middle key goes up, it belongs to none of the halves */
+	struct _s_bp_inner *right = m_bp_tree_inner(_s_bp_tree_node_new(0));
+	uint16_t half = (_S_BP_TREE_KEYS + 1) / 2;
+	uint16_t rest = _S_BP_TREE_KEYS - half;
+
+	memcpy(inner->keys, keys, half * sizeof(void *));
+	memcpy(inner->childs, childs, (half + 1) * sizeof(void *));
+	node->count = half;
+	memcpy(right->keys, keys + half + 1, rest * sizeof(void *));
+	memcpy(right->childs, childs + half + 1, (rest + 1) *
+		sizeof(void *));
+	right->node.count = rest;
+
+	*sep = keys[half];
+	return &right->node;
+}
+
+int s_bp_tree_add(struct s_bp_tree *tree, t_compare_func compare, void *data)
+{
+	m_stats_scope(e_stats_bp_tree_add);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	if (!tree->root) {
+		tree->root = _s_bp_tree_node_new(1);
+		tree->first = tree->last = m_bp_tree_leaf(tree->root);
+	}
+
+	void *key;
+	struct _s_bp_node *right = _s_bp_tree_insert(tree, tree->root, compare,
+		data, &key);
+
+	/* the root has been split: the tree grows by the top */
+	if (right) {
+		struct _s_bp_inner *root = m_bp_tree_inner(_s_bp_tree_node_new(0));
+		root->keys[0] = key;
+		root->childs[0] = tree->root;
+		root->childs[1] = right;
+		root->node.count = 1;
+		tree->root = &root->node;
+	}
+	tree->size++;
+	return 0;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * remove implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Check if a node is under the minimal filling
+ */
+static uint8_t _s_bp_tree_underflow(struct _s_bp_node *node)
+{
+	return node->count < ((node->leaf) ? _S_BP_TREE_DATA_MIN :
+		_S_BP_TREE_KEYS_MIN);
+}
+
+/**
+ * @brief Check if a node can give an item to a sibling
+ */
+static uint8_t _s_bp_tree_can_lend(struct _s_bp_node *node)
+{
+	return node->count > ((node->leaf) ? _S_BP_TREE_DATA_MIN :
+		_S_BP_TREE_KEYS_MIN);
+}
+
+/**
+ * @brief Move the last item of the child i - 1 to the front of the child i
+ */
+static void _s_bp_tree_borrow_left(struct _s_bp_inner *parent, uint16_t i)
+{
+	struct _s_bp_node *left = parent->childs[i - 1];
+	struct _s_bp_node *node = parent->childs[i];
+
+	if (node->leaf) {
+		struct _s_bp_leaf *l = m_bp_tree_leaf(left);
+		struct _s_bp_leaf *n = m_bp_tree_leaf(node);
+
+		memmove(n->data + 1, n->data, node->count * sizeof(void *));
+		n->data[0] = l->data[left->count - 1];
+		parent->keys[i - 1] = n->data[0];
+	} else {
+		struct _s_bp_inner *l = m_bp_tree_inner(left);
+		struct _s_bp_inner *n = m_bp_tree_inner(node);
+
+		memmove(n->keys + 1, n->keys, node->count * sizeof(void *));
+		memmove(n->childs + 1, n->childs, (node->count + 1) *
+			sizeof(void *));
+		n->keys[0] = parent->keys[i - 1];
+		n->childs[0] = l->childs[left->count];
+		parent->keys[i - 1] = l->keys[left->count - 1];
+	}
+	left->count--;
+	node->count++;
+}
+
+/**
+ * @brief Move the first item of the child i + 1 to the back of the child i
+ */
+static void _s_bp_tree_borrow_right(struct _s_bp_inner *parent, uint16_t i)
+{
+	struct _s_bp_node *node = parent->childs[i];
+	struct _s_bp_node *right = parent->childs[i + 1];
+
+	if (node->leaf) {
+		struct _s_bp_leaf *n = m_bp_tree_leaf(node);
+		struct _s_bp_leaf *r = m_bp_tree_leaf(right);
+
+		n->data[node->count] = r->data[0];
+		memmove(r->data, r->data + 1, (right->count - 1) *
+			sizeof(void *));
+		parent->keys[i] = r->data[0];
+	} else {
+		struct _s_bp_inner *n = m_bp_tree_inner(node);
+		struct _s_bp_inner *r = m_bp_tree_inner(right);
+
+		n->keys[node->count] = parent->keys[i];
+		n->childs[node->count + 1] = r->childs[0];
+		parent->keys[i] = r->keys[0];
+		memmove(r->keys, r->keys + 1, (right->count - 1) *
+			sizeof(void *));
+		memmove(r->childs, r->childs + 1, right->count *
+			sizeof(void *));
+	}
+	right->count--;
+	node->count++;
+}
+
+/**
+ * @brief Merge the child i + 1 into the child i
+ */
+static void _s_bp_tree_merge(struct s_bp_tree *tree,
+	struct _s_bp_inner *parent, uint16_t i)
+{
+	struct _s_bp_node *node = parent->childs[i];
+	struct _s_bp_node *right = parent->childs[i + 1];
+
+	if (node->leaf) {
+		struct _s_bp_leaf *n = m_bp_tree_leaf(node);
+		struct _s_bp_leaf *r = m_bp_tree_leaf(right);
+
+		memcpy(n->data + node->count, r->data, right->count *
+			sizeof(void *));
+		node->count += right->count;
+		n->next = r->next;
+		if (n->next)
+			n->next->prev = n;
+		else
+			tree->last = n;
+	} else {
+		struct _s_bp_inner *n = m_bp_tree_inner(node);
+		struct _s_bp_inner *r = m_bp_tree_inner(right);
+
+		n->keys[node->count] = parent->keys[i];
+		memcpy(n->keys + node->count + 1, r->keys, right->count *
+			sizeof(void *));
+		memcpy(n->childs + node->count + 1, r->childs,
+			(right->count + 1) * sizeof(void *));
+		node->count += right->count + 1;
+	}
+	_free(right);
+
+	memmove(parent->keys + i, parent->keys + i + 1,
+		(parent->node.count - i - 1) * sizeof(void *));
+	memmove(parent->childs + i + 1, parent->childs + i + 2,
+		(parent->node.count - i - 1) * sizeof(void *));
+	parent->node.count--;
+}
+
+/**
+ * @brief Bring the child i of a node back to the minimal filling
+ */
+static void _s_bp_tree_rebalance(struct s_bp_tree *tree,
+	struct _s_bp_inner *parent, uint16_t i)
+{
+	if (i > 0 && _s_bp_tree_can_lend(parent->childs[i - 1]))
+		_s_bp_tree_borrow_left(parent, i);
+	else if (i < parent->node.count &&
+		_s_bp_tree_can_lend(parent->childs[i + 1]))
+		_s_bp_tree_borrow_right(parent, i);
+	else if (i > 0)
+		_s_bp_tree_merge(tree, parent, i - 1);
+	else
+		_s_bp_tree_merge(tree, parent, i);
+}
+
+/**
+ * @brief Remove an element from a subtree, fixing the nodes under filled on
+ * the way back
+ * @param tree[in] : tree to modify
+ * @param node[in] : subtree to modify
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to remove
+ * @param removed[out] : element removed
+ * @return 0 on success, -EAGAIN if not found
+ */
+static int _s_bp_tree_erase(struct s_bp_tree *tree, struct _s_bp_node *node,
+	t_compare_func cmp, void *data, void **removed)
+{
+	if (node->leaf) {
+		struct _s_bp_leaf *leaf = m_bp_tree_leaf(node);
+		uint16_t pos = _s_bp_tree_search(leaf->data, node->count, cmp,
+			data, 0);
+
+		if (pos == node->count || cmp(leaf->data[pos], data) != 0)
+			return -EAGAIN;
+		*removed = leaf->data[pos];
+		memmove(leaf->data + pos, leaf->data + pos + 1,
+			(node->count - pos - 1) * sizeof(void *));
+		node->count--;
+		return 0;
+	}
+
+	/* an element equal to data, if any, is on the right of equal keys */
+	struct _s_bp_inner *inner = m_bp_tree_inner(node);
+	uint16_t i = _s_bp_tree_search(inner->keys, node->count, cmp, data, 1);
+	int ret = _s_bp_tree_erase(tree, inner->childs[i], cmp, data, removed);
+
+	if (ret < 0)
+		return ret;
+	/* the separator must not point to the element removed */
+	if (i > 0 && inner->keys[i - 1] == *removed)
+		inner->keys[i - 1] = _s_bp_tree_min(inner->childs[i]);
+	if (_s_bp_tree_underflow(inner->childs[i]))
+		_s_bp_tree_rebalance(tree, inner, i);
+	return 0;
+}
+
+int s_bp_tree_remove(struct s_bp_tree *tree, t_compare_func compare,
+	t_destroy_func destroy, void *data)
+{
+	m_stats_scope(e_stats_bp_tree_remove);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	if (!tree->root)
+		return -EAGAIN;
+
+	void *removed;
+	int ret = _s_bp_tree_erase(tree, tree->root, compare, data, &removed);
+	if (ret < 0)
+		return ret;
+
+	/* the tree shrinks by the top */
+	struct _s_bp_node *root = tree->root;
+	if (!root->leaf && root->count == 0) {
+		tree->root = m_bp_tree_inner(root)->childs[0];
+		_free(root);
+	} else if (root->leaf && root->count == 0) {
+		tree->root = NULL;
+		tree->first = tree->last = NULL;
+		_free(root);
+	}
+	tree->size--;
+
+	if (destroy)
+		destroy(removed);
+	return 0;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * find implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Get the position of the first element not smaller than data
+ * @param tree[in] : tree to browse
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to look for
+ * @param pos[out] : position into the leaf
+ * @return the leaf, NULL if all elements are smaller than data
+ */
+static struct _s_bp_leaf *_s_bp_tree_seek(struct s_bp_tree *tree,
+	t_compare_func cmp, void *data, uint16_t *pos)
+{
+	struct _s_bp_node *node = tree->root;
+
+	if (!node)
+		return NULL;
+	while (!node->leaf) {
+		struct _s_bp_inner *inner = m_bp_tree_inner(node);
+		node = inner->childs[_s_bp_tree_search(inner->keys,
+			node->count, cmp, data, 0)];
+	}
+
+	struct _s_bp_leaf *leaf = m_bp_tree_leaf(node);
+	*pos = _s_bp_tree_search(leaf->data, node->count, cmp, data, 0);
+	if (*pos == node->count) {
+		leaf = leaf->next;
+		*pos = 0;
+	}
+	return leaf;
+}
+
+void *s_bp_tree_lower_bound(struct s_bp_tree *tree, t_compare_func compare,
+	void *data)
+{
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	uint16_t pos;
+	struct _s_bp_leaf *leaf = _s_bp_tree_seek(tree, compare, data, &pos);
+	return (leaf) ? leaf->data[pos] : NULL;
+}
+
+void *s_bp_tree_find(struct s_bp_tree *tree, t_compare_func compare,
+	void *data)
+{
+	m_stats_scope(e_stats_bp_tree_exist);
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	uint16_t pos;
+	struct _s_bp_leaf *leaf = _s_bp_tree_seek(tree, compare, data, &pos);
+	if (!leaf || compare(leaf->data[pos], data) != 0)
+		return NULL;
+	return leaf->data[pos];
+}
+
+int s_bp_tree_exist(struct s_bp_tree *tree, t_compare_func compare,
+	void *data)
+{
+	m_stats_scope(e_stats_bp_tree_exist);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	uint16_t pos;
+	struct _s_bp_leaf *leaf = _s_bp_tree_seek(tree, compare, data, &pos);
+	if (!leaf || compare(leaf->data[pos], data) != 0)
+		return -EAGAIN;
+	return 0;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * foreach implementation
+ * -----------------------------------------------------------------------------
+ */
+int s_bp_tree_foreach(struct s_bp_tree *tree, t_foreach_func foreach,
+	void *user_data)
+{
+	m_stats_scope(e_stats_bp_tree_foreach);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	int ret = 0;
+	for (struct _s_bp_leaf *leaf = tree->first; leaf; leaf = leaf->next)
+		for (uint16_t i = 0; i < leaf->node.count; i++)
+			ret |= foreach(leaf->data[i], user_data);
+	return ret;
+}
+
+int s_bp_tree_foreach_range(struct s_bp_tree *tree, t_compare_func compare,
+	void *lo, void *hi, t_foreach_func foreach, void *user_data)
+{
+	m_stats_scope(e_stats_bp_tree_foreach);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	int ret = 0;
+	uint16_t pos;
+	struct _s_bp_leaf *leaf = _s_bp_tree_seek(tree, compare, lo, &pos);
+	for (; leaf; leaf = leaf->next, pos = 0) {
+		for (; pos < leaf->node.count; pos++) {
+			if (compare(leaf->data[pos], hi) > 0)
+				return ret;
+			ret |= foreach(leaf->data[pos], user_data);
+		}
+	}
+	return ret;
+}
@@ -15,11 +15,16 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include <string.h>
-#include "queue/s_queue.h"
 #include "tree/s_bs_tree.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
+/**
+ * @brief Initial number of slots of the breadth-first ring (power of 2)
+ */
+#define _S_BS_TREE_RING 64
+
 /**
  * @brief The binary search tree structure
  * @param data: user data stored
@@ -59,7 +64,7 @@ static struct s_bs_tree *_s_bs_tree_new(void *data)
 	return tree;
 }
 
-void s_sb_tree_delete(struct s_bs_tree *tree)
+void s_bs_tree_delete(struct s_bs_tree *tree)
 {
 	m_return_if_fail(tree);
 
@@ -142,24 +147,34 @@ void *s_bs_tree_nth_biggest(struct s_bs_tree *tree, uint32_t nth)
 	return m_bs_tree_get_data(_s_bs_tree_nth_biggest(tree, nth, 0));
 }
 
-int s_bs_tree_exist(struct s_bs_tree *tree, t_compare_func cmp, void *data)
+/**
+ * @brief Core function
+ */
+static int _s_bs_tree_exist(struct s_bs_tree *tree, t_compare_func cmp,
+	void *data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(cmp, -EINVAL);
-
 	int ret = cmp(m_bs_tree_get_data(tree), data);
 	if (ret == 0)
 		return 0;
 	else if (ret > 0)
 		return (m_bs_tree_get_left(tree)) ?
-			s_bs_tree_exist(m_bs_tree_get_left(tree), cmp, data) :
+			_s_bs_tree_exist(m_bs_tree_get_left(tree), cmp, data) :
 			-EAGAIN;
 	else
 		return (m_bs_tree_get_right(tree)) ?
-			s_bs_tree_exist(m_bs_tree_get_right(tree), cmp,
+			_s_bs_tree_exist(m_bs_tree_get_right(tree), cmp,
 				data) : -EAGAIN;
 }
 
+int s_bs_tree_exist(struct s_bs_tree *tree, t_compare_func cmp, void *data)
+{
+	m_stats_scope(e_stats_bs_tree_exist);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+
+	return _s_bs_tree_exist(tree, cmp, data);
+}
+
 /**
  * -----------------------------------------------------------------------------
  * add implementation
@@ -180,14 +195,14 @@ static struct s_bs_tree *_s_bs_tree_add(struct s_bs_tree *tree,
 			tree->left = _s_bs_tree_new(data);
 			return m_bs_tree_get_left(tree);
 		}
-		return s_bs_tree_add(m_bs_tree_get_left(tree), compare,
+		return _s_bs_tree_add(m_bs_tree_get_left(tree), compare,
 			data);
 	} else {
 		if (!m_bs_tree_get_right(tree)) {
 			tree->right = _s_bs_tree_new(data);
 			return m_bs_tree_get_right(tree);
 		}
-		return s_bs_tree_add(m_bs_tree_get_right(tree), compare,
+		return _s_bs_tree_add(m_bs_tree_get_right(tree), compare,
 			data);
 	}
 }
@@ -195,7 +210,13 @@ static struct s_bs_tree *_s_bs_tree_add(struct s_bs_tree *tree,
 struct s_bs_tree *s_bs_tree_add(struct s_bs_tree *tree,
 	t_compare_func compare, void *data)
 {
-	return (tree) ? _s_bs_tree_add(tree, compare, data) : _s_bs_tree_new(data);
+	m_stats_scope(e_stats_bs_tree_add);
+	m_return_val_if_fail(compare, tree);
+
+	if (!tree)
+		return _s_bs_tree_new(data);
+	_s_bs_tree_add(tree, compare, data);
+	return tree;
 }
 
 /**
@@ -229,11 +250,13 @@ static struct s_bs_tree *_s_bs_tree_find_min(struct s_bs_tree *tree)
 	if (operator) \
 		s_bs_tree_delete_full((tree), (operator))
 
-struct s_bs_tree *s_bs_tree_remove(struct s_bs_tree *tree,
+/**
+ * @brief Core algorithm
+ */
+static struct s_bs_tree *_s_bs_tree_remove(struct s_bs_tree *tree,
 	t_compare_func compare, t_destroy_func destroy, void *data)
 {
 	m_return_val_if_fail(tree, tree);
-	m_return_val_if_fail(compare, tree);
 
 	struct s_bs_tree *left = m_bs_tree_get_left(tree);
 	struct s_bs_tree *right = m_bs_tree_get_right(tree);
@@ -249,16 +272,26 @@ struct s_bs_tree *s_bs_tree_remove(struct s_bs_tree *tree,
 		}
 		struct s_bs_tree *tmp = _s_bs_tree_find_min(right);
 		tree->data = tmp->data;
-		tree->right = s_bs_tree_remove(right, compare, destroy,
+		tree->right = _s_bs_tree_remove(right, compare, destroy,
 			tmp->data);
 	} else if (ret > 0) {
-		tree->left = s_bs_tree_remove(left, compare, destroy, data);
+		tree->left = _s_bs_tree_remove(left, compare, destroy, data);
 	} else {
-		tree->right = s_bs_tree_remove(right, compare, destroy, data);
+		tree->right = _s_bs_tree_remove(right, compare, destroy, data);
 	}
 	return tree;
 }
 
+struct s_bs_tree *s_bs_tree_remove(struct s_bs_tree *tree,
+	t_compare_func compare, t_destroy_func destroy, void *data)
+{
+	m_stats_scope(e_stats_bs_tree_remove);
+	m_return_val_if_fail(tree, tree);
+	m_return_val_if_fail(compare, tree);
+
+	return _s_bs_tree_remove(tree, compare, destroy, data);
+}
+
 /**
  * -----------------------------------------------------------------------------
  * foreach implementation
@@ -266,74 +299,122 @@ struct s_bs_tree *s_bs_tree_remove(struct s_bs_tree *tree,
  */
 
 /**
- * @brief Pre-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
- * @param tree[in] : tree to visit
- * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
- * @return 0 on success, errno on error
+ * The depth-first traversals are Morris traversals: the right link of the
+ * last node of each left subtree is pointed back to the subtree parent for
+ * the time the subtree is browsed, so no stack is needed whatever the shape
+ * of the tree. Every link is restored before returning.
  */
-static int _s_bs_tree_depth_pre(struct s_bs_tree *tree,
-	t_foreach_func foreach, void *user_data)
-{
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
-
-	struct s_bs_tree *left = m_bs_tree_get_left(tree);
-	struct s_bs_tree *right = m_bs_tree_get_right(tree);
 
-	int ret = foreach(m_bs_tree_get_data(tree), user_data);
-	ret |= (left) ? _s_bs_tree_depth_pre(left, foreach, user_data) : 0;
-	ret |= (right) ? _s_bs_tree_depth_pre(right, foreach, user_data) : 0;
+/**
+ * @brief Get the last node of the left subtree of a node, following a link
+ * already pointed back to the node
+ * @param tree[in] : node with a left child
+ * @return the predecessor of tree
+ */
+static struct s_bs_tree *_s_bs_tree_thread(struct s_bs_tree *tree)
+{
+	struct s_bs_tree *pred = tree->left;
 
-	return ret;
+	while (pred->right && pred->right != tree)
+		pred = pred->right;
+	return pred;
 }
 
 /**
- * @brief Post-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
+ * @brief Pre-order or in-order traversal
  * @param tree[in] : tree to visit
+ * @param pre[in] : 1 for pre-order, 0 for in-order
  * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
+ * @param user_data[in] : user data pass through the callback
  * @return 0 on success, errno on error
  */
-static int _s_bs_tree_depth_post(struct s_bs_tree *tree,
+static int _s_bs_tree_depth(struct s_bs_tree *tree, uint8_t pre,
 	t_foreach_func foreach, void *user_data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
-
-	struct s_bs_tree *left = m_bs_tree_get_left(tree);
-	struct s_bs_tree *right = m_bs_tree_get_right(tree);
+	int ret = 0;
 
-	int ret = (left) ? _s_bs_tree_depth_post(left, foreach, user_data) : 0;
-	ret |= (right) ? _s_bs_tree_depth_post(right, foreach, user_data) : 0;
-	ret |= foreach(m_bs_tree_get_data(tree), user_data);
+	while (tree) {
+		if (!tree->left) {
+			ret |= foreach(tree->data, user_data);
+			tree = tree->right;
+			continue;
+		}
 
+		struct s_bs_tree *pred = _s_bs_tree_thread(tree);
+		if (!pred->right) {
+			/* entering the left subtree */
+			if (pre)
+				ret |= foreach(tree->data, user_data);
+			pred->right = tree;
+			tree = tree->left;
+		} else {
+			/* back from the left subtree */
+			pred->right = NULL;
+			if (!pre)
+				ret |= foreach(tree->data, user_data);
+			tree = tree->right;
+		}
+	}
 	return ret;
 }
 
 /**
- * @brief In-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
+ * @brief Reverse the right links of a right path
+ * @param from[in] : first node of the path
+ * @param to[in] : last node of the path
+ */
+static void _s_bs_tree_reverse(struct s_bs_tree *from, struct s_bs_tree *to)
+{
+	struct s_bs_tree *x = from;
+	struct s_bs_tree *y = from->right;
+
+	while (x != to) {
+		struct s_bs_tree *z = y->right;
+		y->right = x;
+		x = y;
+		y = z;
+	}
+}
+
+/**
+ * @brief Post-order traversal. Back from a left subtree, the right path from
+ * the left child to the predecessor is visited bottom-up; a dummy root holds
+ * the tree as its left subtree so the last path visited is the right spine.
  * @param tree[in] : tree to visit
  * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
+ * @param user_data[in] : user data pass through the callback
  * @return 0 on success, errno on error
  */
-static int _s_bs_tree_depth_in(struct s_bs_tree *tree, t_foreach_func foreach,
-	void *user_data)
+static int _s_bs_tree_depth_post(struct s_bs_tree *tree,
+	t_foreach_func foreach, void *user_data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
+	struct s_bs_tree dummy = { NULL, tree, NULL };
+	int ret = 0;
 
-	struct s_bs_tree *left = m_bs_tree_get_left(tree);
-	struct s_bs_tree *right = m_bs_tree_get_right(tree);
+	tree = &dummy;
+	while (tree) {
+		if (!tree->left) {
+			tree = tree->right;
+			continue;
+		}
 
-	int ret = (left) ? _s_bs_tree_depth_post(left, foreach, user_data) : 0;
-	ret |= foreach(m_bs_tree_get_data(tree), user_data);
-	ret |= (right) ? _s_bs_tree_depth_post(right, foreach, user_data) : 0;
+		struct s_bs_tree *pred = _s_bs_tree_thread(tree);
+		if (!pred->right) {
+			pred->right = tree;
+			tree = tree->left;
+			continue;
+		}
 
+		_s_bs_tree_reverse(tree->left, pred);
+		for (struct s_bs_tree *node = pred;; node = node->right) {
+			ret |= foreach(node->data, user_data);
+			if (node == tree->left)
+				break;
+		}
+		_s_bs_tree_reverse(pred, tree->left);
+		pred->right = NULL;
+		tree = tree->right;
+	}
 	return ret;
 }
 
@@ -341,7 +422,8 @@ static int _s_bs_tree_depth_in(struct s_bs_tree *tree, t_foreach_func foreach,
  * @brief Contrasting with depth-first order is breadth-first order, which
  * always attempts to visit the node closest to the root that it has not already
  * visited. See breadth-first search for more information. Also called a
- * level-order traversal.
+ * level-order traversal. The pending nodes are kept into a single ring,
+ * doubled when full.
  * @param tree[in] : tree to visit
  * @param foreach[in] : foreach user callback
  * @param data[in] : user data pass through the callback
@@ -350,40 +432,55 @@ static int _s_bs_tree_depth_in(struct s_bs_tree *tree, t_foreach_func foreach,
 static int _s_bs_tree_breath(struct s_bs_tree *tree, t_foreach_func foreach,
 	void *data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
-
+	uint32_t capacity = _S_BS_TREE_RING;
+	struct s_bs_tree **ring = _malloc(capacity * sizeof(struct s_bs_tree *));
+	uint32_t head = 0;
+	uint32_t count = 1;
 	int ret = 0;
-	struct s_queue *queue = s_queue_new();
-	ret = s_queue_push(queue, tree);
 
-	while (!s_queue_empty(queue)) {
-		struct s_bs_tree *tmp = s_queue_pop(queue);
-		struct s_bs_tree *left = m_bs_tree_get_left(tmp);
-		struct s_bs_tree *right = m_bs_tree_get_right(tmp);
+	ring[0] = tree;
+	while (count) {
+		struct s_bs_tree *tmp = ring[head];
+		struct s_bs_tree *children[2] = {
+			m_bs_tree_get_left(tmp), m_bs_tree_get_right(tmp)
+		};
 
+		head = (head + 1) & (capacity - 1);
+		count--;
 		ret |= foreach(m_bs_tree_get_data(tmp), data);
-		ret |= (left) ? s_queue_push(queue, left) : 0;
-		ret |= (right) ? s_queue_push(queue, right) : 0;
+		for (uint8_t i = 0; i < 2; i++) {
+			if (!children[i])
+				continue;
+			if (count == capacity) {
+				/* unwrap the ring at the end of the new space */
+				ring = _realloc(ring, 2 * capacity *
+					sizeof(struct s_bs_tree *));
+				for (uint32_t j = 0; j < head; j++)
+					ring[capacity + j] = ring[j];
+				capacity *= 2;
+			}
+			ring[(head + count++) & (capacity - 1)] = children[i];
+		}
 	}
 
-	s_queue_delete(queue);
+	_free(ring);
 	return ret;
 }
 
 int s_bs_tree_foreach(struct s_bs_tree *tree, enum e_tree_browse type,
 	t_foreach_func foreach, void *user_data)
 {
+	m_stats_scope(e_stats_bs_tree_foreach);
 	m_return_val_if_fail(tree, -EINVAL);
 	m_return_val_if_fail(foreach, -EINVAL);
 
 	switch (type) {
 	case e_tree_depth_pre:
-		return _s_bs_tree_depth_pre(tree, foreach, user_data);
+		return _s_bs_tree_depth(tree, 1, foreach, user_data);
 	case e_tree_depth_post:
 		return _s_bs_tree_depth_post(tree, foreach, user_data);
 	case e_tree_depth_in:
-		return _s_bs_tree_depth_in(tree, foreach, user_data);
+		return _s_bs_tree_depth(tree, 0, foreach, user_data);
 	case e_tree_breath:
 		return _s_bs_tree_breath(tree, foreach, user_data);
 	}
@@ -0,0 +1,491 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "tree/s_rb_compact.h"
+#include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Default number of nodes of the pool
+ */
+#define _S_RB_COMPACT_DEFAULT_SIZE 16
+
+/**
+ * @brief A node of the pool. The index 0 is a black sentinel standing for
+ * all the leaves, so the rebalancing never checks for a missing node.
+ * @param data: user data (next free index when the node is free)
+ * @param parent_color: index of the parent, shifted left by one, and the
+ * color in the low bit
+ * @param left: index of the left child
+ * @param right: index of the right child
+ */
+struct _s_rb_compact_node {
+	void *data;
+	uint32_t parent_color;
+	uint32_t left;
+	uint32_t right;
+};
+
+/**
+ * @brief The compact tree structure
+ * @param nodes: pool of the nodes
+ * @param capacity: number of nodes of the pool, sentinel included
+ * @param used: number of nodes of the pool ever used, sentinel included
+ * @param free: first free node, 0 if none
+ * @param root: index of the root, 0 if empty
+ * @param size: number of elements
+ */
+struct s_rb_compact {
+	struct _s_rb_compact_node *nodes;
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t free;
+	uint32_t root;
+	uint32_t size;
+};
+
+/**
+ * @brief Biggest pool that _realloc() can allocate
+ */
+#define _S_RB_COMPACT_MAX_SIZE \
+	(UINT32_MAX / sizeof(struct _s_rb_compact_node))
+
+/**
+ * @brief Convenience macros to access the fields of a node by index
+ */
+#define m_rb_compact_node(tree, i) (&(tree)->nodes[i])
+#define m_rb_compact_get_parent(tree, i) \
+	((tree)->nodes[i].parent_color >> 1)
+#define m_rb_compact_get_color(tree, i) \
+	((enum _e_color)((tree)->nodes[i].parent_color & 1))
+#define m_rb_compact_is_red(tree, i) \
+	(m_rb_compact_get_color(tree, i) == _e_red)
+#define m_rb_compact_set_parent(tree, i, p) { \
+	(tree)->nodes[i].parent_color = ((uint32_t)(p) << 1) | \
+		((tree)->nodes[i].parent_color & 1); \
+}
+#define m_rb_compact_set_color(tree, i, col) { \
+	(tree)->nodes[i].parent_color = ((tree)->nodes[i].parent_color & \
+		~(uint32_t)1) | (uint32_t)(col); \
+}
+
+struct s_rb_compact *s_rb_compact_new(void)
+{
+	struct s_rb_compact *tree = _malloc(sizeof(struct s_rb_compact));
+
+	tree->capacity = _S_RB_COMPACT_DEFAULT_SIZE;
+	tree->nodes = _malloc(tree->capacity *
+		sizeof(struct _s_rb_compact_node));
+	tree->nodes[0].parent_color = _e_black;
+	tree->used = 1;
+	return tree;
+}
+
+void s_rb_compact_delete(struct s_rb_compact *tree)
+{
+	s_rb_compact_delete_full(tree, NULL);
+}
+
+/**
+ * @brief Call a destroy function on the elements of a subtree
+ */
+static void _s_rb_compact_clean(struct s_rb_compact *tree, uint32_t node,
+	t_destroy_func destroy)
+{
+	while (node) {
+		_s_rb_compact_clean(tree, tree->nodes[node].left, destroy);
+		destroy(tree->nodes[node].data);
+		node = tree->nodes[node].right;
+	}
+}
+
+void s_rb_compact_delete_full(struct s_rb_compact *tree,
+	t_destroy_func destroy)
+{
+	m_return_if_fail(tree);
+
+	if (destroy)
+		_s_rb_compact_clean(tree, tree->root, destroy);
+	_free(tree->nodes);
+	_free(tree);
+}
+
+int s_rb_compact_reserve(struct s_rb_compact *tree, uint32_t size)
+{
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(size < _S_RB_COMPACT_MAX_SIZE, -ENOMEM);
+
+	/* the sentinel takes the first node */
+	if (size < tree->capacity)
+		return 0;
+
+	uint32_t capacity = tree->capacity;
+	while (capacity <= size)
+		capacity = (capacity > _S_RB_COMPACT_MAX_SIZE / 2) ?
+			(uint32_t)_S_RB_COMPACT_MAX_SIZE : capacity << 1;
+	tree->nodes = _realloc(tree->nodes, capacity *
+		sizeof(struct _s_rb_compact_node));
+	tree->capacity = capacity;
+	return 0;
+}
+
+/**
+ * @brief Take a node from the free list or from the end of the pool
+ * @param tree[in] : tree owning the pool
+ * @return the index of a red node without child, 0 if the pool is full
+ */
+static uint32_t _s_rb_compact_alloc(struct s_rb_compact *tree)
+{
+	uint32_t node = tree->free;
+
+	if (node) {
+		tree->free = (uint32_t)(uintptr_t)tree->nodes[node].data;
+	} else {
+		if (tree->used == tree->capacity &&
+			s_rb_compact_reserve(tree, tree->capacity) < 0)
+			return 0;
+		node = tree->used++;
+	}
+	tree->nodes[node].parent_color = _e_red;
+	tree->nodes[node].left = 0;
+	tree->nodes[node].right = 0;
+	return node;
+}
+
+/**
+ * @brief Give back a node to the free list
+ */
+static void _s_rb_compact_free(struct s_rb_compact *tree, uint32_t node)
+{
+	tree->nodes[node].data = (void *)(uintptr_t)tree->free;
+	tree->free = node;
+}
+
+/**
+ * @brief Find the node holding an element
+ * @return the index of the node, 0 if not found
+ */
+static uint32_t _s_rb_compact_find(struct s_rb_compact *tree,
+	t_compare_func compare, void *data)
+{
+	uint32_t node = tree->root;
+
+	while (node) {
+		int ret = compare(tree->nodes[node].data, data);
+		if (ret == 0)
+			break;
+		node = (ret > 0) ? tree->nodes[node].left :
+			tree->nodes[node].right;
+	}
+	return node;
+}
+
+/**
+ * @brief Replace the link of the parent of a node by another node
+ */
+static void _s_rb_compact_replace(struct s_rb_compact *tree, uint32_t node,
+	uint32_t by)
+{
+	uint32_t parent = m_rb_compact_get_parent(tree, node);
+
+	if (!parent)
+		tree->root = by;
+	else if (tree->nodes[parent].left == node)
+		tree->nodes[parent].left = by;
+	else
+		tree->nodes[parent].right = by;
+	m_rb_compact_set_parent(tree, by, parent)
+}
+
+/**
+ * @brief Rotate a node to the left, its right child taking its place
+ */
+static void _s_rb_compact_rotate_left(struct s_rb_compact *tree,
+	uint32_t node)
+{
+	uint32_t right = tree->nodes[node].right;
+
+	tree->nodes[node].right = tree->nodes[right].left;
+	if (tree->nodes[right].left)
+		m_rb_compact_set_parent(tree, tree->nodes[right].left, node)
+	_s_rb_compact_replace(tree, node, right);
+	tree->nodes[right].left = node;
+	m_rb_compact_set_parent(tree, node, right)
+}
+
+/**
+ * @brief Rotate a node to the right, its left child taking its place
+ */
+static void _s_rb_compact_rotate_right(struct s_rb_compact *tree,
+	uint32_t node)
+{
+	uint32_t left = tree->nodes[node].left;
+
+	tree->nodes[node].left = tree->nodes[left].right;
+	if (tree->nodes[left].right)
+		m_rb_compact_set_parent(tree, tree->nodes[left].right, node)
+	_s_rb_compact_replace(tree, node, left);
+	tree->nodes[left].right = node;
+	m_rb_compact_set_parent(tree, node, left)
+}
+
+/**
+ * @brief Fix the red conflict after an insertion
+ * @param tree[in] : tree to modify
+ * @param node[in] : red node added
+ */
+static void _s_rb_compact_add_fixup(struct s_rb_compact *tree, uint32_t node)
+{
+	uint32_t parent;
+
+	while ((parent = m_rb_compact_get_parent(tree, node)) &&
+		m_rb_compact_is_red(tree, parent)) {
+		uint32_t grand = m_rb_compact_get_parent(tree, parent);
+		uint8_t left = (tree->nodes[grand].left == parent);
+		uint32_t uncle = (left) ? tree->nodes[grand].right :
+			tree->nodes[grand].left;
+
+		if (m_rb_compact_is_red(tree, uncle)) {
+			m_rb_compact_set_color(tree, parent, _e_black)
+			m_rb_compact_set_color(tree, uncle, _e_black)
+			m_rb_compact_set_color(tree, grand, _e_red)
+			node = grand;
+			continue;
+		}
+		if (left && node == tree->nodes[parent].right) {
+			_s_rb_compact_rotate_left(tree, parent);
+			parent = node;
+		} else if (!left && node == tree->nodes[parent].left) {
+			_s_rb_compact_rotate_right(tree, parent);
+			parent = node;
+		}
+		m_rb_compact_set_color(tree, parent, _e_black)
+		m_rb_compact_set_color(tree, grand, _e_red)
+		if (left)
+			_s_rb_compact_rotate_right(tree, grand);
+		else
+			_s_rb_compact_rotate_left(tree, grand);
+		break;
+	}
+	m_rb_compact_set_color(tree, tree->root, _e_black)
+}
+
+int s_rb_compact_add(struct s_rb_compact *tree, t_compare_func compare,
+	void *data)
+{
+	m_stats_scope(e_stats_rb_compact_add);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	uint32_t node = _s_rb_compact_alloc(tree);
+	m_return_val_if_fail(node, -ENOMEM);
+
+	uint32_t parent = 0;
+	uint32_t *link = &tree->root;
+
+	/* the pool may have moved, the links are taken after the alloc */
+	while (*link) {
+		parent = *link;
+		link = (compare(tree->nodes[parent].data, data) > 0) ?
+			&tree->nodes[parent].left : &tree->nodes[parent].right;
+	}
+	tree->nodes[node].data = data;
+	m_rb_compact_set_parent(tree, node, parent)
+	*link = node;
+	tree->size++;
+
+	_s_rb_compact_add_fixup(tree, node);
+	return 0;
+}
+
+/**
+ * @brief Fix the missing black node after a removal
+ * @param tree[in] : tree to modify
+ * @param node[in] : node (possibly the sentinel) taking the place of the
+ * black node removed
+ */
+static void _s_rb_compact_remove_fixup(struct s_rb_compact *tree,
+	uint32_t node)
+{
+	while (node != tree->root && !m_rb_compact_is_red(tree, node)) {
+		uint32_t parent = m_rb_compact_get_parent(tree, node);
+		uint8_t left = (tree->nodes[parent].left == node);
+		uint32_t sibling = (left) ? tree->nodes[parent].right :
+			tree->nodes[parent].left;
+
+		if (m_rb_compact_is_red(tree, sibling)) {
+			m_rb_compact_set_color(tree, sibling, _e_black)
+			m_rb_compact_set_color(tree, parent, _e_red)
+			if (left) {
+				_s_rb_compact_rotate_left(tree, parent);
+				sibling = tree->nodes[parent].right;
+			} else {
+				_s_rb_compact_rotate_right(tree, parent);
+				sibling = tree->nodes[parent].left;
+			}
+		}
+
+		uint32_t near = (left) ? tree->nodes[sibling].left :
+			tree->nodes[sibling].right;
+		uint32_t far = (left) ? tree->nodes[sibling].right :
+			tree->nodes[sibling].left;
+
+		if (!m_rb_compact_is_red(tree, near) &&
+			!m_rb_compact_is_red(tree, far)) {
+			m_rb_compact_set_color(tree, sibling, _e_red)
+			node = parent;
+			continue;
+		}
+		if (!m_rb_compact_is_red(tree, far)) {
+			m_rb_compact_set_color(tree, near, _e_black)
+			m_rb_compact_set_color(tree, sibling, _e_red)
+			if (left)
+				_s_rb_compact_rotate_right(tree, sibling);
+			else
+				_s_rb_compact_rotate_left(tree, sibling);
+			far = sibling;
+			sibling = near;
+		}
+		m_rb_compact_set_color(tree, sibling,
+			m_rb_compact_get_color(tree, parent))
+		m_rb_compact_set_color(tree, parent, _e_black)
+		m_rb_compact_set_color(tree, far, _e_black)
+		if (left)
+			_s_rb_compact_rotate_left(tree, parent);
+		else
+			_s_rb_compact_rotate_right(tree, parent);
+		node = tree->root;
+	}
+	m_rb_compact_set_color(tree, node, _e_black)
+}
+
+int s_rb_compact_remove(struct s_rb_compact *tree, t_compare_func compare,
+	t_destroy_func destroy, void *data)
+{
+	m_stats_scope(e_stats_rb_compact_remove);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	uint32_t node = _s_rb_compact_find(tree, compare, data);
+	if (!node)
+		return -EAGAIN;
+
+	struct _s_rb_compact_node *n = m_rb_compact_node(tree, node);
+	enum _e_color color = m_rb_compact_get_color(tree, node);
+	uint32_t child;
+
+	if (!n->left) {
+		child = n->right;
+		_s_rb_compact_replace(tree, node, child);
+	} else if (!n->right) {
+		child = n->left;
+		_s_rb_compact_replace(tree, node, child);
+	} else {
+		/* the successor takes the place and the color of node */
+		uint32_t next = n->right;
+		while (tree->nodes[next].left)
+			next = tree->nodes[next].left;
+
+		color = m_rb_compact_get_color(tree, next);
+		child = tree->nodes[next].right;
+		if (m_rb_compact_get_parent(tree, next) == node) {
+			/* the sentinel too, for the fixup to climb up */
+			m_rb_compact_set_parent(tree, child, next)
+		} else {
+			_s_rb_compact_replace(tree, next, child);
+			tree->nodes[next].right = n->right;
+			m_rb_compact_set_parent(tree, n->right, next)
+		}
+		_s_rb_compact_replace(tree, node, next);
+		tree->nodes[next].left = n->left;
+		m_rb_compact_set_parent(tree, n->left, next)
+		m_rb_compact_set_color(tree, next,
+			m_rb_compact_get_color(tree, node))
+	}
+
+	if (color == _e_black)
+		_s_rb_compact_remove_fixup(tree, child);
+	tree->nodes[0].parent_color = _e_black;
+
+	if (destroy)
+		destroy(n->data);
+	_s_rb_compact_free(tree, node);
+	tree->size--;
+	return 0;
+}
+
+void *s_rb_compact_get(struct s_rb_compact *tree, t_compare_func compare,
+	void *data)
+{
+	m_stats_scope(e_stats_rb_compact_exist);
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	uint32_t node = _s_rb_compact_find(tree, compare, data);
+	return (node) ? tree->nodes[node].data : NULL;
+}
+
+int s_rb_compact_exist(struct s_rb_compact *tree, t_compare_func compare,
+	void *data)
+{
+	m_stats_scope(e_stats_rb_compact_exist);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	return (_s_rb_compact_find(tree, compare, data)) ? 0 : -EAGAIN;
+}
+
+uint32_t s_rb_compact_size(const struct s_rb_compact *tree)
+{
+	m_return_val_if_fail(tree, 0);
+
+	return tree->size;
+}
+
+int s_rb_compact_foreach(struct s_rb_compact *tree, t_foreach_func foreach,
+	void *user_data)
+{
+	m_stats_scope(e_stats_rb_compact_foreach);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	uint32_t node = tree->root;
+	int ret = 0;
+
+	if (!node)
+		return ret;
+
+	/* in order walk through the parent links, without stack */
+	while (tree->nodes[node].left)
+		node = tree->nodes[node].left;
+	while (node) {
+		ret |= foreach(tree->nodes[node].data, user_data);
+		if (tree->nodes[node].right) {
+			node = tree->nodes[node].right;
+			while (tree->nodes[node].left)
+				node = tree->nodes[node].left;
+		} else {
+			uint32_t child;
+			do {
+				child = node;
+				node = m_rb_compact_get_parent(tree, node);
+			} while (node && tree->nodes[node].right == child);
+		}
+	}
+	return ret;
+}
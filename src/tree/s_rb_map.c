@@ -0,0 +1,212 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "tree/s_rb_map.h"
+#include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief An entry of the map: a red/black tree node whose data is the key
+ * @param node: tree node, first so the tree functions handle the entry
+ * @param value: user value
+ */
+struct _s_rb_map_entry {
+	struct s_rb_tree node;
+	void *value;
+};
+
+/**
+ * @brief The map structure
+ * @param root: root of the tree of the entries
+ */
+struct s_rb_map {
+	struct s_rb_tree *root;
+};
+
+/**
+ * @brief Convenience macro to get the entry of a node
+ */
+#define m_rb_map_entry(node) ((struct _s_rb_map_entry *)(node))
+
+struct s_rb_map *s_rb_map_new(void)
+{
+	return _malloc(sizeof(struct s_rb_map));
+}
+
+/**
+ * @brief Release a subtree of entries
+ */
+static void _s_rb_map_clean(struct s_rb_tree *node, t_destroy_func key_destroy,
+	t_destroy_func value_destroy)
+{
+	while (node) {
+		struct s_rb_tree *right = m_rb_tree_get_right(node);
+
+		_s_rb_map_clean(m_rb_tree_get_left(node), key_destroy,
+			value_destroy);
+		if (key_destroy)
+			key_destroy(node->data);
+		if (value_destroy)
+			value_destroy(m_rb_map_entry(node)->value);
+		_free(node);
+		node = right;
+	}
+}
+
+void s_rb_map_delete(struct s_rb_map *map)
+{
+	m_return_if_fail(map);
+
+	_s_rb_map_clean(map->root, NULL, NULL);
+	_free(map);
+}
+
+void s_rb_map_delete_full(struct s_rb_map *map, t_destroy_func key_destroy,
+	t_destroy_func value_destroy)
+{
+	m_return_if_fail(map);
+
+	_s_rb_map_clean(map->root, key_destroy, value_destroy);
+	_free(map);
+}
+
+uint32_t s_rb_map_size(const struct s_rb_map *map)
+{
+	m_return_val_if_fail(map, 0);
+
+	return m_rb_tree_get_size(map->root);
+}
+
+void *s_rb_map_get(struct s_rb_map *map, t_compare_func compare, void *key)
+{
+	m_stats_scope(e_stats_rb_map_exist);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct s_rb_tree *node = s_rb_tree_find(map->root, compare, key);
+	return (node) ? m_rb_map_entry(node)->value : NULL;
+}
+
+int s_rb_map_exist(struct s_rb_map *map, t_compare_func compare, void *key)
+{
+	m_stats_scope(e_stats_rb_map_exist);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(compare, -EINVAL);
+
+	return (s_rb_tree_find(map->root, compare, key)) ? 0 : -EAGAIN;
+}
+
+void **s_rb_map_upsert(struct s_rb_map *map, t_compare_func compare,
+	void *key, void *value, uint8_t *added)
+{
+	m_stats_scope(e_stats_rb_map_add);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct s_rb_tree *parent = NULL;
+	struct s_rb_tree *node = map->root;
+	int ret = 0;
+
+	while (node) {
+		ret = compare(m_rb_tree_get_data(node), key);
+		if (ret == 0) {
+			if (added)
+				*added = 0;
+			return &m_rb_map_entry(node)->value;
+		}
+		parent = node;
+		node = (ret > 0) ? m_rb_tree_get_left(node) :
+			m_rb_tree_get_right(node);
+	}
+
+	struct _s_rb_map_entry *entry = _malloc(sizeof(struct _s_rb_map_entry));
+	entry->node.data = key;
+	entry->node.size = 1;
+	m_rb_tree_set_parent(&entry->node, parent)
+	entry->value = value;
+	node = &entry->node;
+
+	if (!parent) {
+		map->root = node;
+	} else {
+		if (ret > 0)
+			m_rb_tree_set_left(parent, node)
+		else
+			m_rb_tree_set_right(parent, node)
+		_s_rb_tree_add_size(parent, 1);
+		_s_rb_tree_rearrange(&map->root, node);
+	}
+	m_rb_tree_set_color(map->root, _e_black);
+
+	if (added)
+		*added = 1;
+	return &entry->value;
+}
+
+void *s_rb_map_put(struct s_rb_map *map, t_compare_func compare, void *key,
+	void *value)
+{
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	uint8_t added;
+	void **slot = s_rb_map_upsert(map, compare, key, value, &added);
+	if (added)
+		return NULL;
+
+	void *previous = *slot;
+	*slot = value;
+	return previous;
+}
+
+void *s_rb_map_remove(struct s_rb_map *map, t_compare_func compare,
+	t_destroy_func key_destroy, void *key)
+{
+	m_stats_scope(e_stats_rb_map_remove);
+	m_return_val_if_fail(map, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct s_rb_tree *node = s_rb_tree_find(map->root, compare, key);
+	if (!node)
+		return NULL;
+
+	void *value = m_rb_map_entry(node)->value;
+	_s_rb_tree_unlink(&map->root, node);
+	if (key_destroy)
+		key_destroy(node->data);
+	_free(node);
+	return value;
+}
+
+int s_rb_map_foreach(struct s_rb_map *map, t_map_foreach_func foreach,
+	void *user_data)
+{
+	m_stats_scope(e_stats_rb_map_foreach);
+	m_return_val_if_fail(map, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	int ret = 0;
+	if (!map->root)
+		return ret;
+
+	for (struct s_rb_tree *node = s_rb_tree_first(map->root); node;
+		node = s_rb_tree_next(node))
+		ret |= foreach(node->data, m_rb_map_entry(node)->value,
+			user_data);
+	return ret;
+}
@@ -0,0 +1,452 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <sched.h>
+#include <stdatomic.h>
+#include "tree/s_rb_persist.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * The tree is a left-leaning red/black tree: its recursive insertion and
+ * deletion only touch the nodes of the path and their children, so each
+ * node can be copied just before being changed. The base version stays
+ * referenced by the caller, so every node of the path is shared and copied
+ * once; only the nodes created by the same update (copies and new leaf) are
+ * referenced once and changed in place by the rotations and color flips
+ * that follow.
+ */
+
+/**
+ * @brief The persistent node structure, a version is its root node
+ * @param data: user data stored
+ * @param refs: number of parents and user references
+ * @param size: number of nodes of the subtree
+ * @param red: 1 if the link from the parent is red
+ * @param left: left child
+ * @param right: right child
+ */
+struct s_rb_persist {
+	void *data;
+	atomic_uint refs;
+	uint32_t size;
+	uint8_t red;
+	struct s_rb_persist *left;
+	struct s_rb_persist *right;
+};
+
+/**
+ * @brief The snapshot structure. The readers pin the counter of the current
+ * epoch while they take their reference, and check the epoch did not move
+ * meanwhile; the writer switches the epoch then waits for the counter of the
+ * previous one before releasing the old version.
+ * @param version: current version
+ * @param epoch: current epoch
+ * @param pins: readers taking a reference, per epoch parity
+ */
+struct s_rb_snapshot {
+	_Atomic(struct s_rb_persist *) version;
+	atomic_uint epoch;
+	atomic_uint pins[2];
+};
+
+/**
+ * @brief Convenience macros on possibly NULL nodes
+ */
+#define m_rb_persist_is_red(node) ((node) ? (node)->red : 0)
+#define m_rb_persist_get_size(node) ((node) ? (node)->size : 0)
+#define m_rb_persist_update_size(node) \
+	((node)->size = m_rb_persist_get_size((node)->left) + \
+		m_rb_persist_get_size((node)->right) + 1)
+
+struct s_rb_persist *s_rb_persist_acquire(struct s_rb_persist *version)
+{
+	if (version)
+		atomic_fetch_add_explicit(&version->refs, 1,
+			memory_order_relaxed);
+	return version;
+}
+
+void s_rb_persist_release(struct s_rb_persist *version)
+{
+	/* the right spine is followed in a loop, the left one recursively */
+	while (version && atomic_fetch_sub_explicit(&version->refs, 1,
+		memory_order_acq_rel) == 1) {
+		struct s_rb_persist *right = version->right;
+
+		s_rb_persist_release(version->left);
+		_free(version);
+		version = right;
+	}
+}
+
+/**
+ * @brief Allocate a single red node
+ */
+static struct s_rb_persist *_s_rb_persist_new(void *data)
+{
+	struct s_rb_persist *node = _malloc(sizeof(struct s_rb_persist));
+	node->data = data;
+	atomic_init(&node->refs, 1);
+	node->size = 1;
+	node->red = 1;
+	return node;
+}
+
+/**
+ * @brief Get a node that can be changed in place, in place of a node whose
+ * reference is held by the caller
+ * @param node[in] : node referenced by the caller, released if copied
+ * @return node itself if not shared, a copy otherwise
+ */
+static struct s_rb_persist *_s_rb_persist_own(struct s_rb_persist *node)
+{
+	if (!node || atomic_load_explicit(&node->refs,
+		memory_order_acquire) == 1)
+		return node;
+
+	struct s_rb_persist *copy = _s_rb_persist_new(node->data);
+	copy->size = node->size;
+	copy->red = node->red;
+	copy->left = s_rb_persist_acquire(node->left);
+	copy->right = s_rb_persist_acquire(node->right);
+	s_rb_persist_release(node);
+	return copy;
+}
+
+/**
+ * @brief Rotate left an owned node
+ */
+static struct s_rb_persist *_s_rb_persist_rotate_left(struct s_rb_persist *h)
+{
+	struct s_rb_persist *x = _s_rb_persist_own(h->right);
+
+	h->right = x->left;
+	x->left = h;
+	x->red = h->red;
+	h->red = 1;
+	x->size = h->size;
+	m_rb_persist_update_size(h);
+	return x;
+}
+
+/**
+ * @brief Rotate right an owned node
+ */
+static struct s_rb_persist *_s_rb_persist_rotate_right(struct s_rb_persist *h)
+{
+	struct s_rb_persist *x = _s_rb_persist_own(h->left);
+
+	h->left = x->right;
+	x->right = h;
+	x->red = h->red;
+	h->red = 1;
+	x->size = h->size;
+	m_rb_persist_update_size(h);
+	return x;
+}
+
+/**
+ * @brief Flip the colors of an owned node and its children
+ */
+static void _s_rb_persist_flip(struct s_rb_persist *h)
+{
+	h->red = !h->red;
+	h->left = _s_rb_persist_own(h->left);
+	h->right = _s_rb_persist_own(h->right);
+	if (h->left)
+		h->left->red = !h->left->red;
+	if (h->right)
+		h->right->red = !h->right->red;
+}
+
+/**
+ * @brief Restore the left-leaning invariants of an owned node
+ */
+static struct s_rb_persist *_s_rb_persist_balance(struct s_rb_persist *h)
+{
+	if (m_rb_persist_is_red(h->right) && !m_rb_persist_is_red(h->left))
+		h = _s_rb_persist_rotate_left(h);
+	if (m_rb_persist_is_red(h->left) &&
+		m_rb_persist_is_red(h->left->left))
+		h = _s_rb_persist_rotate_right(h);
+	if (m_rb_persist_is_red(h->left) && m_rb_persist_is_red(h->right))
+		_s_rb_persist_flip(h);
+	m_rb_persist_update_size(h);
+	return h;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * add implementation
+ * -----------------------------------------------------------------------------
+ */
+static struct s_rb_persist *_s_rb_persist_insert(struct s_rb_persist *h,
+	t_compare_func cmp, void *data)
+{
+	if (!h)
+		return _s_rb_persist_new(data);
+
+	h = _s_rb_persist_own(h);
+	if (cmp(h->data, data) > 0)
+		h->left = _s_rb_persist_insert(h->left, cmp, data);
+	else
+		h->right = _s_rb_persist_insert(h->right, cmp, data);
+	return _s_rb_persist_balance(h);
+}
+
+struct s_rb_persist *s_rb_persist_add(struct s_rb_persist *version,
+	t_compare_func compare, void *data)
+{
+	m_return_val_if_fail(compare, NULL);
+
+	/* the erase path relies on distinct elements */
+	struct s_rb_persist *root = s_rb_persist_acquire(version);
+	if (s_rb_persist_exist(root, compare, data) == 0)
+		return root;
+
+	root = _s_rb_persist_insert(root, compare, data);
+	root->red = 0;
+	return root;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * remove implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Make the left child of an owned node (or one of its children) red
+ */
+static struct s_rb_persist *_s_rb_persist_move_red_left(
+	struct s_rb_persist *h)
+{
+	_s_rb_persist_flip(h);
+	if (m_rb_persist_is_red(h->right->left)) {
+		h->right = _s_rb_persist_rotate_right(h->right);
+		h = _s_rb_persist_rotate_left(h);
+		_s_rb_persist_flip(h);
+	}
+	return h;
+}
+
+/**
+ * @brief Make the right child of an owned node (or one of its children) red
+ */
+static struct s_rb_persist *_s_rb_persist_move_red_right(
+	struct s_rb_persist *h)
+{
+	_s_rb_persist_flip(h);
+	if (m_rb_persist_is_red(h->left->left)) {
+		h = _s_rb_persist_rotate_right(h);
+		_s_rb_persist_flip(h);
+	}
+	return h;
+}
+
+/**
+ * @brief Remove the smallest node of a subtree
+ */
+static struct s_rb_persist *_s_rb_persist_erase_min(struct s_rb_persist *h)
+{
+	if (!h->left) {
+		/* a node without left child is a leaf in a left leaning tree */
+		s_rb_persist_release(h);
+		return NULL;
+	}
+
+	h = _s_rb_persist_own(h);
+	if (!m_rb_persist_is_red(h->left) &&
+		!m_rb_persist_is_red(h->left->left))
+		h = _s_rb_persist_move_red_left(h);
+	h->left = _s_rb_persist_erase_min(h->left);
+	return _s_rb_persist_balance(h);
+}
+
+/**
+ * @brief Remove an element known to be into a subtree
+ */
+static struct s_rb_persist *_s_rb_persist_erase(struct s_rb_persist *h,
+	t_compare_func cmp, void *data)
+{
+	h = _s_rb_persist_own(h);
+	if (cmp(h->data, data) > 0) {
+		if (!m_rb_persist_is_red(h->left) &&
+			!m_rb_persist_is_red(h->left->left))
+			h = _s_rb_persist_move_red_left(h);
+		h->left = _s_rb_persist_erase(h->left, cmp, data);
+	} else {
+		if (m_rb_persist_is_red(h->left))
+			h = _s_rb_persist_rotate_right(h);
+		if (cmp(h->data, data) == 0 && !h->right) {
+			s_rb_persist_release(h);
+			return NULL;
+		}
+		if (!m_rb_persist_is_red(h->right) &&
+			!m_rb_persist_is_red(h->right->left))
+			h = _s_rb_persist_move_red_right(h);
+		if (cmp(h->data, data) == 0) {
+			/* the successor data takes the place of data */
+			struct s_rb_persist *min = h->right;
+			while (min->left)
+				min = min->left;
+			h->data = min->data;
+			h->right = _s_rb_persist_erase_min(h->right);
+		} else {
+			h->right = _s_rb_persist_erase(h->right, cmp, data);
+		}
+	}
+	return _s_rb_persist_balance(h);
+}
+
+struct s_rb_persist *s_rb_persist_remove(struct s_rb_persist *version,
+	t_compare_func compare, void *data)
+{
+	m_return_val_if_fail(compare, NULL);
+
+	struct s_rb_persist *root = s_rb_persist_acquire(version);
+	if (s_rb_persist_exist(root, compare, data) < 0)
+		return root;
+
+	root = _s_rb_persist_own(root);
+	if (!m_rb_persist_is_red(root->left) &&
+		!m_rb_persist_is_red(root->right))
+		root->red = 1;
+	root = _s_rb_persist_erase(root, compare, data);
+	if (root)
+		root->red = 0;
+	return root;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * find implementation
+ * -----------------------------------------------------------------------------
+ */
+uint32_t s_rb_persist_size(const struct s_rb_persist *version)
+{
+	return m_rb_persist_get_size(version);
+}
+
+void *s_rb_persist_find(const struct s_rb_persist *version,
+	t_compare_func compare, void *data)
+{
+	m_return_val_if_fail(compare, NULL);
+
+	while (version) {
+		int ret = compare(version->data, data);
+		if (ret == 0)
+			return version->data;
+		version = (ret > 0) ? version->left : version->right;
+	}
+	return NULL;
+}
+
+int s_rb_persist_exist(const struct s_rb_persist *version,
+	t_compare_func compare, void *data)
+{
+	m_return_val_if_fail(compare, -EINVAL);
+
+	while (version) {
+		int ret = compare(version->data, data);
+		if (ret == 0)
+			return 0;
+		version = (ret > 0) ? version->left : version->right;
+	}
+	return -EAGAIN;
+}
+
+int s_rb_persist_foreach(const struct s_rb_persist *version,
+	t_foreach_func foreach, void *user_data)
+{
+	m_return_val_if_fail(foreach, -EINVAL);
+
+	int ret = 0;
+	while (version) {
+		ret |= s_rb_persist_foreach(version->left, foreach, user_data);
+		ret |= foreach(version->data, user_data);
+		version = version->right;
+	}
+	return ret;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * snapshot implementation
+ * -----------------------------------------------------------------------------
+ */
+struct s_rb_snapshot *s_rb_snapshot_new(void)
+{
+	struct s_rb_snapshot *snapshot = _malloc(sizeof(struct s_rb_snapshot));
+	atomic_init(&snapshot->version, NULL);
+	atomic_init(&snapshot->epoch, 0);
+	atomic_init(&snapshot->pins[0], 0);
+	atomic_init(&snapshot->pins[1], 0);
+	return snapshot;
+}
+
+void s_rb_snapshot_delete(struct s_rb_snapshot *snapshot)
+{
+	m_return_if_fail(snapshot);
+
+	s_rb_persist_release(atomic_load(&snapshot->version));
+	_free(snapshot);
+}
+
+struct s_rb_persist *s_rb_snapshot_get(struct s_rb_snapshot *snapshot)
+{
+	m_return_val_if_fail(snapshot, NULL);
+
+	uint32_t epoch = atomic_load(&snapshot->epoch);
+	uint32_t parity = epoch & 1;
+
+	/*
+	 * the pin holds back the writer only if the epoch did not move before
+	 * it was taken, otherwise the version loaded may be freed by a later
+	 * writer waiting on the other parity
+	 */
+	for (;;) {
+		atomic_fetch_add(&snapshot->pins[parity], 1);
+		uint32_t now = atomic_load(&snapshot->epoch);
+		if (now == epoch)
+			break;
+		atomic_fetch_sub(&snapshot->pins[parity], 1);
+		epoch = now;
+		parity = epoch & 1;
+	}
+	struct s_rb_persist *version = s_rb_persist_acquire(
+		atomic_load(&snapshot->version));
+	atomic_fetch_sub(&snapshot->pins[parity], 1);
+	return version;
+}
+
+void s_rb_snapshot_set(struct s_rb_snapshot *snapshot,
+	struct s_rb_persist *version)
+{
+	m_return_if_fail(snapshot);
+
+	struct s_rb_persist *old = atomic_exchange(&snapshot->version, version);
+
+	/*
+	 * a reader pinned on the previous epoch may have loaded old, a reader
+	 * pinning after the switch sees the new version
+	 */
+	uint32_t parity = atomic_fetch_add(&snapshot->epoch, 1) & 1;
+	while (atomic_load(&snapshot->pins[parity]))
+		sched_yield();
+	s_rb_persist_release(old);
+}
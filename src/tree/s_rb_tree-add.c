@@ -15,6 +15,7 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -28,20 +29,12 @@ static struct s_rb_tree *_s_rb_tree_new(struct s_rb_tree *parent, void *data)
 {
 	struct s_rb_tree *new = _malloc(sizeof(struct s_rb_tree));
 	new->data = data;
-	new->parent = parent;
+	new->size = 1;
+	m_rb_tree_set_parent(new, parent)
 
 	return new;
 }
 
-/**
- * @brief Convenience macro to check if we are in left left case
- * @param x[in] : inserted node
- */
-#define m_rb_tree_is_ll_case(x) \
-	(m_rb_tree_is_left(m_rb_tree_get_grand_parent(x), \
-		m_rb_tree_get_parent(x)) && \
-		m_rb_tree_is_left(m_rb_tree_get_parent(x), x))
-
 /**
  * @brief Convenience macro to check if we are in left right case
  * @param x[in] : inserted node
@@ -51,15 +44,6 @@ static struct s_rb_tree *_s_rb_tree_new(struct s_rb_tree *parent, void *data)
 		m_rb_tree_get_parent(x)) && \
 		m_rb_tree_is_right(m_rb_tree_get_parent(x), x))
 
-/**
- * @brief Convenience macro to check if we are in right right case
- * @param x[in] : inserted node
- */
-#define m_rb_tree_is_rr_case(x) \
-	(m_rb_tree_is_right(m_rb_tree_get_grand_parent(x), \
-		m_rb_tree_get_parent(x)) && \
-		m_rb_tree_is_right(m_rb_tree_get_parent(x), x))
-
 /**
  * @brief Convenience macro to check if we are in right left case
  * @param x[in] : inserted node
@@ -69,67 +53,122 @@ static struct s_rb_tree *_s_rb_tree_new(struct s_rb_tree *parent, void *data)
 		m_rb_tree_get_parent(x)) && \
 		m_rb_tree_is_left(m_rb_tree_get_parent(x), x))
 
-/**
- * @brief Rearrange the tree to be a valid red/black tree
- * @param x[in] : newly added node
- */
-static void _s_rb_tree_rearrange(struct s_rb_tree *x)
+void _s_rb_tree_rearrange(struct s_rb_tree **root, struct s_rb_tree *x)
 {
 	m_return_if_fail(x);
 
-	struct s_rb_tree *gp = m_rb_tree_get_grand_parent(x);
-	if (m_rb_tree_get_color(m_rb_tree_get_parent(x)) == _e_red ||
-			!m_rb_tree_get_parent(x)) {
-		if (m_rb_tree_is_ll_case(x)) {
-ll_case:
-			m_rb_tree_set_color(x, _e_black);
-			_s_rb_tree_right_rotate(gp);
-		} else if (m_rb_tree_is_lr_case(x)) {
-			_s_rb_tree_left_rotate(m_rb_tree_get_parent(x));
-			goto ll_case;
-		} else if (m_rb_tree_is_rr_case(x)) {
-rr_case:
-			m_rb_tree_set_color(x, _e_black);
-			_s_rb_tree_left_rotate(gp);
-		} else if (m_rb_tree_is_rl_case(x)) {
-			_s_rb_tree_right_rotate(m_rb_tree_get_parent(x));
-			goto rr_case;
+	/* a red parent is never the root, so the grand parent exists */
+	while (m_rb_tree_get_color(m_rb_tree_get_parent(x)) == _e_red) {
+		struct s_rb_tree *p = m_rb_tree_get_parent(x);
+		struct s_rb_tree *gp = m_rb_tree_get_parent(p);
+		struct s_rb_tree *uncle = _s_rb_tree_get_uncle(x);
+
+		/* red uncle: push the conflict up to the grand parent */
+		if (m_rb_tree_get_color(uncle) == _e_red) {
+			m_rb_tree_set_color(p, _e_black);
+			m_rb_tree_set_color(uncle, _e_black);
+			m_rb_tree_set_color(gp, _e_red);
+			x = gp;
+		} else if (m_rb_tree_is_left(gp, p)) {
+			/* left right case is turned into a left left case */
+			if (m_rb_tree_is_lr_case(x)) {
+				x = p;
+				_s_rb_tree_left_rotate(root, x);
+			}
+			/* left left case */
+			m_rb_tree_set_color(m_rb_tree_get_parent(x), _e_black);
+			m_rb_tree_set_color(gp, _e_red);
+			_s_rb_tree_right_rotate(root, gp);
+		} else {
+			/* right left case is turned into a right right case */
+			if (m_rb_tree_is_rl_case(x)) {
+				x = p;
+				_s_rb_tree_right_rotate(root, x);
+			}
+			/* right right case */
+			m_rb_tree_set_color(m_rb_tree_get_parent(x), _e_black);
+			m_rb_tree_set_color(gp, _e_red);
+			_s_rb_tree_left_rotate(root, gp);
 		}
-		if (m_rb_tree_get_parent(x))
-			_s_rb_tree_rearrange(m_rb_tree_get_parent(x));
 	}
 }
 
 /**
  * @brief Add an element in the tree according to the binary search tree
  * algorithm
- * @param tree[in] : root to modify
+ * @param tree[in] : node to descend from
  * @param compare[in] : compare operator
- * @param destroy[in] : destroy operator
  * @param data[in] : data to add in the tree
+ * @return the new leaf
  */
 static struct s_rb_tree *_s_bs_tree_add(struct s_rb_tree *tree,
 	t_compare_func compare, void *data)
 {
-	m_return_val_if_fail(tree, tree);
-	m_return_val_if_fail(compare, tree);
-
-	int ret = compare(m_rb_tree_get_data(tree), data);
-	if (ret > 0) {
-		if (!m_rb_tree_get_left(tree)) {
-			m_rb_tree_set_left(tree, _s_rb_tree_new(tree, data));
-			return m_rb_tree_get_left(tree);
+	for (;;) {
+		if (compare(m_rb_tree_get_data(tree), data) > 0) {
+			if (!m_rb_tree_get_left(tree)) {
+				m_rb_tree_set_left(tree, _s_rb_tree_new(tree, data))
+				return m_rb_tree_get_left(tree);
+			}
+			tree = m_rb_tree_get_left(tree);
+		} else {
+			if (!m_rb_tree_get_right(tree)) {
+				m_rb_tree_set_right(tree, _s_rb_tree_new(tree, data))
+				return m_rb_tree_get_right(tree);
+			}
+			tree = m_rb_tree_get_right(tree);
 		}
-		return _s_bs_tree_add(m_rb_tree_get_left(tree), compare,
-			data);
+	}
+}
+
+/**
+ * @brief Insert an element from a node of the tree then rebalance it
+ * @param tree[in] : root of the tree to modify, updated
+ * @param from[in] : node to descend from, NULL to create the root
+ * @param compare[in] : compare operator
+ * @param data[in] : data to add in the tree
+ * @return the node holding data
+ */
+static struct s_rb_tree *_s_rb_tree_insert(struct s_rb_tree **tree,
+	struct s_rb_tree *from, t_compare_func compare, void *data)
+{
+	struct s_rb_tree *x;
+
+	/* 1) perform a bst insertion or a creation if no root */
+	if (from) {
+		x = _s_bs_tree_add(from, compare, data);
+		_s_rb_tree_add_size(m_rb_tree_get_parent(x), 1);
+		/* 2) recolor and rotate up from the new (red) node */
+		_s_rb_tree_rearrange(tree, x);
 	} else {
-		if (!m_rb_tree_get_right(tree)) {
-			m_rb_tree_set_right(tree, _s_rb_tree_new(tree, data));
-			return m_rb_tree_get_right(tree);
-		}
-		return _s_bs_tree_add(m_rb_tree_get_right(tree), compare,
-			data);
+		x = *tree = _s_rb_tree_new(NULL, data);
 	}
+	/* 3) change color if x is root */
+	m_rb_tree_set_color(*tree, _e_black);
+	return x;
+}
+
+struct s_rb_tree *s_rb_tree_add_node(struct s_rb_tree **tree,
+	t_compare_func compare, void *data)
+{
+	m_stats_scope(e_stats_rb_tree_add);
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	return _s_rb_tree_insert(tree, *tree, compare, data);
+}
+
+struct s_rb_tree *s_rb_tree_add_hint(struct s_rb_tree **tree,
+	struct s_rb_tree *hint, t_compare_func compare, void *data)
+{
+	m_stats_scope(e_stats_rb_tree_add);
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(compare, NULL);
+
+	struct s_rb_tree *from = *tree;
+	if (hint && from)
+		from = _s_rb_tree_finger(hint, compare, data);
+	return _s_rb_tree_insert(tree, from, compare, data);
 }
 
 struct s_rb_tree *s_rb_tree_add(struct s_rb_tree *tree, t_compare_func compare,
@@ -137,14 +176,6 @@ struct s_rb_tree *s_rb_tree_add(struct s_rb_tree *tree, t_compare_func compare,
 {
 	m_return_val_if_fail(compare, tree);
 
-	/* 1) perform a bst insertion or a creation if no root */
-	if (tree) {
-		struct s_rb_tree *x = _s_bs_tree_add(tree, compare, data);
-		_s_rb_tree_rearrange(x);
-	} else {
-		tree = _s_rb_tree_new(NULL, data);
-	}
-	/* 2) change color if x is root */
-	m_rb_tree_set_color(tree, _e_black);
+	s_rb_tree_add_node(&tree, compare, data);
 	return tree;
 }
@@ -0,0 +1,110 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "list/s_list.h"
+#include "s_rb_tree-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * @brief Allocate the block of nodes of a tree
+ * @param size[in] : number of nodes, at least 1
+ * @return a valid pointer on success, NULL on error (too big)
+ */
+static struct _s_rb_tree_pool *_s_rb_tree_pool_new(uint32_t size)
+{
+	m_return_val_if_fail(size <= (UINT32_MAX - sizeof(struct _s_rb_tree_pool))
+		/ sizeof(struct s_rb_tree), NULL);
+
+	struct _s_rb_tree_pool *pool = _malloc(sizeof(struct _s_rb_tree_pool) +
+		size * sizeof(struct s_rb_tree));
+	pool->refs = size;
+	for (uint32_t i = 0; i < size; i++)
+		pool->nodes[i].slot = i + 1;
+	return pool;
+}
+
+/**
+ * @brief Link the nodes [lo, hi[ as a perfectly balanced subtree, each node
+ * holding already its data. All the leaves are at depth red or red - 1, so
+ * the nodes of the deepest level are colored red and every path gets the
+ * same number of black nodes.
+ * @param nodes[in] : nodes sorted by data
+ * @param lo[in] : first node of the subtree
+ * @param hi[in] : end of the subtree
+ * @param parent[in] : parent of the subtree
+ * @param depth[in] : depth of the subtree root
+ * @param red[in] : depth of the red level
+ * @return the root of the subtree, NULL if empty
+ */
+static struct s_rb_tree *_s_rb_tree_link(struct s_rb_tree *nodes, uint32_t lo,
+	uint32_t hi, struct s_rb_tree *parent, uint32_t depth, uint32_t red)
+{
+	if (lo >= hi)
+		return NULL;
+
+	uint32_t mid = lo + (hi - lo) / 2;
+	struct s_rb_tree *node = nodes + mid;
+
+	node->parent_color = (uintptr_t)parent |
+		((depth == red && depth > 0) ? _e_red : _e_black);
+	node->size = hi - lo;
+	node->left = _s_rb_tree_link(nodes, lo, mid, node, depth + 1, red);
+	node->right = _s_rb_tree_link(nodes, mid + 1, hi, node, depth + 1,
+		red);
+	return node;
+}
+
+/**
+ * @brief Get the depth of the deepest level of a balanced tree
+ * @param size[in] : number of nodes, at least 1
+ */
+static uint32_t _s_rb_tree_depth(uint32_t size)
+{
+	return 31 - __builtin_clz(size);
+}
+
+struct s_rb_tree *s_rb_tree_new_from_array(void **data, uint32_t size)
+{
+	m_return_val_if_fail(data, NULL);
+	m_return_val_if_fail(size > 0, NULL);
+
+	struct _s_rb_tree_pool *pool = _s_rb_tree_pool_new(size);
+	m_return_val_if_fail(pool, NULL);
+
+	for (uint32_t i = 0; i < size; i++)
+		pool->nodes[i].data = data[i];
+	return _s_rb_tree_link(pool->nodes, 0, size, NULL, 0,
+		_s_rb_tree_depth(size));
+}
+
+struct s_rb_tree *s_rb_tree_new_from_list(struct s_list *list)
+{
+	m_return_val_if_fail(list, NULL);
+
+	uint32_t size = 0;
+	for (struct s_list *it = list; it; it = m_list_next(it))
+		size++;
+
+	struct _s_rb_tree_pool *pool = _s_rb_tree_pool_new(size);
+	m_return_val_if_fail(pool, NULL);
+
+	uint32_t i = 0;
+	for (struct s_list *it = list; it; it = m_list_next(it))
+		pool->nodes[i++].data = m_list_data(it);
+	return _s_rb_tree_link(pool->nodes, 0, size, NULL, 0,
+		_s_rb_tree_depth(size));
+}
@@ -0,0 +1,506 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include "thread/s_executor.h"
+#include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
+#include "m_utils.h"
+
+/**
+ * Under that number of elements, the set operations do not fork anymore
+ */
+#define _S_RB_TREE_GRAIN 4096
+
+/**
+ * @brief A tree with a black root (or empty) and its black height, the
+ * number of black nodes on a path from the root to a leaf. The heights are
+ * measured once by the public entry points then derived at each step, so a
+ * join only costs the walk down the spine.
+ * @param root: root of the tree
+ * @param height: black height of the tree
+ */
+struct _s_rb_tree_part {
+	struct s_rb_tree *root;
+	uint32_t height;
+};
+
+/**
+ * @brief Measure the black height of a tree in O(log n)
+ * @param tree[in] : root of a tree (black or NULL)
+ * @return the tree with its height
+ */
+static struct _s_rb_tree_part _s_rb_tree_measure(struct s_rb_tree *tree)
+{
+	struct _s_rb_tree_part part = {tree, 0};
+
+	for (; tree; tree = m_rb_tree_get_left(tree))
+		part.height += m_rb_tree_is_black(tree);
+	return part;
+}
+
+/**
+ * @brief Turn a subtree into a tree on its own (black root without parent)
+ * @param tree[in] : subtree to detach
+ * @return the new root
+ */
+static struct s_rb_tree *_s_rb_tree_cut(struct s_rb_tree *tree)
+{
+	m_rb_tree_set_parent(tree, NULL)
+	m_rb_tree_set_color(tree, _e_black)
+	return tree;
+}
+
+/**
+ * @brief Detach a child of the root of a tree. Below the black root, the
+ * child has one black node less, plus one if the child is red and turned
+ * black.
+ * @param tree[in] : parent tree
+ * @param child[in] : child of the root (may be NULL)
+ * @return the child as a tree on its own
+ */
+static struct _s_rb_tree_part _s_rb_tree_child(struct _s_rb_tree_part tree,
+	struct s_rb_tree *child)
+{
+	struct _s_rb_tree_part part = {
+		child, tree.height - 1 + (child && !m_rb_tree_is_black(child))
+	};
+
+	_s_rb_tree_cut(child);
+	return part;
+}
+
+/**
+ * @brief Turn a node into a single red node
+ * @param node[in] : node to reset
+ */
+static void _s_rb_tree_single(struct s_rb_tree *node)
+{
+	node->parent_color = _e_red;
+	node->left = NULL;
+	node->right = NULL;
+	node->size = 1;
+}
+
+/**
+ * @brief Join two trees around a middle node. The node is hung on the spine
+ * of the higher tree at the level of the other one, then the red conflict is
+ * fixed like after an insertion. The tree only grows if the fix turns the
+ * root red.
+ * @param left[in] : tree of the elements before node
+ * @param node[in] : single node
+ * @param right[in] : tree of the elements after node
+ * @return the new tree
+ */
+static struct _s_rb_tree_part _s_rb_tree_join3(struct _s_rb_tree_part left,
+	struct s_rb_tree *node, struct _s_rb_tree_part right)
+{
+	uint32_t lh = left.height;
+	uint32_t rh = right.height;
+	struct _s_rb_tree_part ret;
+	struct s_rb_tree *p = NULL;
+	struct s_rb_tree *y;
+	uint32_t h;
+
+	_s_rb_tree_single(node);
+	if (lh >= rh) {
+		/* first black node of the right spine as high as right */
+		for (ret = left, y = left.root, h = lh; y &&
+			(!m_rb_tree_is_black(y) || h != rh);
+			p = y, y = m_rb_tree_get_right(y))
+			h -= m_rb_tree_is_black(y);
+		node->left = y;
+		node->right = right.root;
+	} else {
+		for (ret = right, y = right.root, h = rh; y &&
+			(!m_rb_tree_is_black(y) || h != lh);
+			p = y, y = m_rb_tree_get_left(y))
+			h -= m_rb_tree_is_black(y);
+		node->left = left.root;
+		node->right = y;
+	}
+	m_rb_tree_set_parent(node->left, node)
+	m_rb_tree_set_parent(node->right, node)
+	m_rb_tree_update_size(node);
+	m_rb_tree_set_parent(node, p)
+	if (!p) {
+		/* both trees are as high, node becomes the black root */
+		ret.root = _s_rb_tree_cut(node);
+		ret.height++;
+		return ret;
+	}
+
+	if (lh >= rh) {
+		p->right = node;
+		_s_rb_tree_add_size(p, m_rb_tree_get_size(right.root) + 1);
+	} else {
+		p->left = node;
+		_s_rb_tree_add_size(p, m_rb_tree_get_size(left.root) + 1);
+	}
+	_s_rb_tree_rearrange(&ret.root, node);
+	ret.height += !m_rb_tree_is_black(ret.root);
+	_s_rb_tree_cut(ret.root);
+	return ret;
+}
+
+/**
+ * @brief Take out the last node of a tree
+ * @param tree[in] : tree to modify, consumed
+ * @param rest[out] : the other nodes
+ * @return the last node
+ */
+static struct s_rb_tree *_s_rb_tree_split_last(struct _s_rb_tree_part tree,
+	struct _s_rb_tree_part *rest)
+{
+	struct s_rb_tree *node = tree.root;
+	struct _s_rb_tree_part l = _s_rb_tree_child(tree, node->left);
+	struct _s_rb_tree_part r = _s_rb_tree_child(tree, node->right);
+	struct _s_rb_tree_part middle;
+
+	if (!r.root) {
+		*rest = l;
+		return node;
+	}
+
+	struct s_rb_tree *last = _s_rb_tree_split_last(r, &middle);
+	*rest = _s_rb_tree_join3(l, node, middle);
+	return last;
+}
+
+/**
+ * @brief Concatenate two trees, the last node of left becoming the middle
+ * @param left[in] : tree of the first elements
+ * @param right[in] : tree of the last elements
+ * @return the new tree
+ */
+static struct _s_rb_tree_part _s_rb_tree_join2(struct _s_rb_tree_part left,
+	struct _s_rb_tree_part right)
+{
+	if (!left.root)
+		return right;
+	if (!right.root)
+		return left;
+
+	struct _s_rb_tree_part rest;
+	struct s_rb_tree *node = _s_rb_tree_split_last(left, &rest);
+	return _s_rb_tree_join3(rest, node, right);
+}
+
+/**
+ * @brief Split a tree in two trees around a data
+ * @param tree[in] : tree to split, consumed
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to split on
+ * @param or_equal[in] : 1 to put the elements equal to data on the left
+ * @param left[out] : elements smaller than data
+ * @param right[out] : elements bigger than data
+ * @param found[out] : if not NULL, receives the node equal to data (NULL if
+ * not found), kept out of both trees
+ */
+static void _s_rb_tree_split(struct _s_rb_tree_part tree, t_compare_func cmp,
+	void *data, uint8_t or_equal, struct _s_rb_tree_part *left,
+	struct _s_rb_tree_part *right, struct s_rb_tree **found)
+{
+	if (found)
+		*found = NULL;
+	if (!tree.root) {
+		*left = *right = tree;
+		return;
+	}
+
+	struct s_rb_tree *node = tree.root;
+	struct _s_rb_tree_part l = _s_rb_tree_child(tree, node->left);
+	struct _s_rb_tree_part r = _s_rb_tree_child(tree, node->right);
+	struct _s_rb_tree_part middle;
+	int ret = cmp(m_rb_tree_get_data(node), data);
+
+	if (found && ret == 0) {
+		*found = node;
+		*left = l;
+		*right = r;
+	} else if (ret < 0 || (or_equal && ret == 0)) {
+		_s_rb_tree_split(r, cmp, data, or_equal, &middle, right, found);
+		*left = _s_rb_tree_join3(l, node, middle);
+	} else {
+		_s_rb_tree_split(l, cmp, data, or_equal, left, &middle, found);
+		*right = _s_rb_tree_join3(middle, node, r);
+	}
+}
+
+int s_rb_tree_split(struct s_rb_tree **tree, t_compare_func cmp, void *data,
+	struct s_rb_tree **right)
+{
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(right, -EINVAL);
+
+	struct _s_rb_tree_part l;
+	struct _s_rb_tree_part r;
+
+	_s_rb_tree_split(_s_rb_tree_measure(*tree), cmp, data, 0, &l, &r,
+		NULL);
+	*tree = l.root;
+	*right = r.root;
+	return 0;
+}
+
+struct s_rb_tree *s_rb_tree_join(struct s_rb_tree *left,
+	struct s_rb_tree *right)
+{
+	return _s_rb_tree_join2(_s_rb_tree_measure(left),
+		_s_rb_tree_measure(right)).root;
+}
+
+int s_rb_tree_remove_range(struct s_rb_tree **tree, t_compare_func cmp,
+	void *lo, void *hi, t_destroy_func destroy)
+{
+	m_stats_scope(e_stats_rb_tree_remove);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(cmp, -EINVAL);
+
+	struct _s_rb_tree_part left;
+	struct _s_rb_tree_part middle;
+	struct _s_rb_tree_part right;
+
+	_s_rb_tree_split(_s_rb_tree_measure(*tree), cmp, lo, 0, &left, &middle,
+		NULL);
+	_s_rb_tree_split(middle, cmp, hi, 1, &middle, &right, NULL);
+	*tree = _s_rb_tree_join2(left, right).root;
+
+	int ret = m_rb_tree_get_size(middle.root);
+	if (middle.root)
+		s_rb_tree_delete_full(middle.root, destroy);
+	return ret;
+}
+
+/**
+ * -----------------------------------------------------------------------------
+ * set implementation
+ * -----------------------------------------------------------------------------
+ */
+
+struct _s_rb_tree_set;
+
+/**
+ * @brief Prototype of a set operation
+ */
+typedef struct _s_rb_tree_part (*_t_set_func)(
+	const struct _s_rb_tree_set *set, struct _s_rb_tree_part tree,
+	struct _s_rb_tree_part other);
+
+/**
+ * @brief The parameters shared by a whole set operation
+ * @param func: operation
+ * @param cmp: compare element function
+ * @param destroy: destroy element function (may be NULL)
+ * @param executor: executor running the forks (may be NULL)
+ */
+struct _s_rb_tree_set {
+	_t_set_func func;
+	t_compare_func cmp;
+	t_destroy_func destroy;
+	struct s_executor *executor;
+};
+
+/**
+ * @brief A set operation on a pair of subtrees
+ * @param set: shared parameters
+ * @param tree: first operand
+ * @param other: second operand, its height is only kept by the union which
+ * consumes it
+ * @param ret: result
+ */
+struct _s_rb_tree_task {
+	const struct _s_rb_tree_set *set;
+	struct _s_rb_tree_part tree;
+	struct _s_rb_tree_part other;
+	struct _s_rb_tree_part ret;
+};
+
+/**
+ * @brief Task function running a set operation
+ */
+static int _s_rb_tree_task_run(void *data)
+{
+	struct _s_rb_tree_task *task = data;
+
+	task->ret = task->set->func(task->set, task->tree, task->other);
+	return 0;
+}
+
+/**
+ * @brief Run a set operation on the left and right parts, in parallel when
+ * they are big enough and an executor is given
+ * @param set[in] : shared parameters
+ * @param left[in] : operands of the left part, result on return
+ * @param right[in] : operands of the right part, result on return
+ */
+static void _s_rb_tree_fork(const struct _s_rb_tree_set *set,
+	struct _s_rb_tree_task *left, struct _s_rb_tree_task *right)
+{
+	struct s_wait_group *group = NULL;
+
+	left->set = right->set = set;
+	if (set->executor && m_rb_tree_get_size(left->tree.root) +
+		m_rb_tree_get_size(left->other.root) >= _S_RB_TREE_GRAIN) {
+		group = s_wait_group_new();
+		if (s_executor_spawn(set->executor, group, _s_rb_tree_task_run,
+			left) < 0) {
+			s_wait_group_delete(group);
+			group = NULL;
+		}
+	}
+	if (!group)
+		_s_rb_tree_task_run(left);
+	_s_rb_tree_task_run(right);
+	if (group) {
+		s_executor_wait(set->executor, group);
+		s_wait_group_delete(group);
+	}
+}
+
+/**
+ * @brief Release a single node and its element
+ */
+static void _s_rb_tree_drop(const struct _s_rb_tree_set *set,
+	struct s_rb_tree *node)
+{
+	if (set->destroy)
+		set->destroy(m_rb_tree_get_data(node));
+	_s_rb_tree_free(node);
+}
+
+/**
+ * @brief Union: the nodes of other are moved into tree, the root of other
+ * split tree then both sides are merged recursively
+ */
+static struct _s_rb_tree_part _s_rb_tree_union(
+	const struct _s_rb_tree_set *set, struct _s_rb_tree_part tree,
+	struct _s_rb_tree_part other)
+{
+	if (!tree.root)
+		return other;
+	if (!other.root)
+		return tree;
+
+	struct s_rb_tree *pivot = other.root;
+	struct _s_rb_tree_task left = {
+		.other = _s_rb_tree_child(other, pivot->left)
+	};
+	struct _s_rb_tree_task right = {
+		.other = _s_rb_tree_child(other, pivot->right)
+	};
+	struct s_rb_tree *node;
+
+	_s_rb_tree_split(tree, set->cmp, pivot->data, 0, &left.tree,
+		&right.tree, &node);
+	/* the element of tree is kept over the one of other */
+	if (node)
+		_s_rb_tree_drop(set, pivot);
+	else
+		node = pivot;
+
+	_s_rb_tree_fork(set, &left, &right);
+	return _s_rb_tree_join3(left.ret, node, right.ret);
+}
+
+/**
+ * @brief Intersection: tree is split around each node of other, which is
+ * only read
+ */
+static struct _s_rb_tree_part _s_rb_tree_intersection(
+	const struct _s_rb_tree_set *set, struct _s_rb_tree_part tree,
+	struct _s_rb_tree_part other)
+{
+	if (!tree.root)
+		return tree;
+	if (!other.root) {
+		s_rb_tree_delete_full(tree.root, set->destroy);
+		return other;
+	}
+
+	struct _s_rb_tree_task left = {.other = {other.root->left, 0}};
+	struct _s_rb_tree_task right = {.other = {other.root->right, 0}};
+	struct s_rb_tree *node;
+
+	_s_rb_tree_split(tree, set->cmp, other.root->data, 0, &left.tree,
+		&right.tree, &node);
+
+	_s_rb_tree_fork(set, &left, &right);
+	return (node) ? _s_rb_tree_join3(left.ret, node, right.ret) :
+		_s_rb_tree_join2(left.ret, right.ret);
+}
+
+/**
+ * @brief Difference: tree is split around each node of other, which is only
+ * read
+ */
+static struct _s_rb_tree_part _s_rb_tree_difference(
+	const struct _s_rb_tree_set *set, struct _s_rb_tree_part tree,
+	struct _s_rb_tree_part other)
+{
+	if (!tree.root || !other.root)
+		return tree;
+
+	struct _s_rb_tree_task left = {.other = {other.root->left, 0}};
+	struct _s_rb_tree_task right = {.other = {other.root->right, 0}};
+	struct s_rb_tree *node;
+
+	_s_rb_tree_split(tree, set->cmp, other.root->data, 0, &left.tree,
+		&right.tree, &node);
+	if (node)
+		_s_rb_tree_drop(set, node);
+
+	_s_rb_tree_fork(set, &left, &right);
+	return _s_rb_tree_join2(left.ret, right.ret);
+}
+
+struct s_rb_tree *s_rb_tree_union(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor)
+{
+	m_return_val_if_fail(cmp, tree);
+
+	struct _s_rb_tree_set set = {_s_rb_tree_union, cmp, destroy, executor};
+	return _s_rb_tree_union(&set, _s_rb_tree_measure(tree),
+		_s_rb_tree_measure(other)).root;
+}
+
+struct s_rb_tree *s_rb_tree_intersection(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor)
+{
+	m_return_val_if_fail(cmp, tree);
+
+	struct _s_rb_tree_set set = {_s_rb_tree_intersection, cmp, destroy,
+		executor};
+	struct _s_rb_tree_part none = {other, 0};
+	return _s_rb_tree_intersection(&set, _s_rb_tree_measure(tree),
+		none).root;
+}
+
+struct s_rb_tree *s_rb_tree_difference(struct s_rb_tree *tree,
+	struct s_rb_tree *other, t_compare_func cmp, t_destroy_func destroy,
+	struct s_executor *executor)
+{
+	m_return_val_if_fail(cmp, tree);
+
+	struct _s_rb_tree_set set = {_s_rb_tree_difference, cmp, destroy,
+		executor};
+	struct _s_rb_tree_part none = {other, 0};
+	return _s_rb_tree_difference(&set, _s_rb_tree_measure(tree),
+		none).root;
+}
@@ -15,6 +15,7 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include "s_rb_tree-private.h"
+#include "m_alloc.h"
 #include "m_utils.h"
 
 struct s_rb_tree *_s_rb_tree_get_uncle(struct s_rb_tree *tree)
@@ -30,6 +31,41 @@ struct s_rb_tree *_s_rb_tree_get_uncle(struct s_rb_tree *tree)
 		return m_rb_tree_get_left(gp);
 }
 
+void _s_rb_tree_free(struct s_rb_tree *tree)
+{
+	m_return_if_fail(tree);
+
+	if (!tree->slot) {
+		_free(tree);
+		return;
+	}
+
+	/* the set operations may release nodes from several threads */
+	struct _s_rb_tree_pool *pool = m_rb_tree_get_pool(tree);
+	if (__atomic_sub_fetch(&pool->refs, 1, __ATOMIC_ACQ_REL) == 0)
+		_free(pool);
+}
+
+void _s_rb_tree_add_size(struct s_rb_tree *tree, int32_t delta)
+{
+	for (; tree; tree = m_rb_tree_get_parent(tree))
+		tree->size += delta;
+}
+
+void _s_rb_tree_transplant(struct s_rb_tree **root, struct s_rb_tree *u,
+	struct s_rb_tree *v)
+{
+	struct s_rb_tree *parent = m_rb_tree_get_parent(u);
+
+	if (!parent)
+		*root = v;
+	else if (m_rb_tree_is_left(parent, u))
+		m_rb_tree_set_left(parent, v)
+	else
+		m_rb_tree_set_right(parent, v)
+	m_rb_tree_set_parent(v, parent);
+}
+
 /**
  * Exemple :
  *          a              b
@@ -37,35 +73,27 @@ struct s_rb_tree *_s_rb_tree_get_uncle(struct s_rb_tree *tree)
  *        b   c   =>     d   a
  *       / \                / \
  *      d   e              e   c
- * the content of C/D/E stay unchanged after the rotation
+ * the nodes are relinked, every data stay in its own node
  */
-void _s_rb_tree_right_rotate(struct s_rb_tree *a)
+void _s_rb_tree_right_rotate(struct s_rb_tree **root, struct s_rb_tree *a)
 {
 	m_return_if_fail(a);
+	m_return_if_fail(m_rb_tree_get_left(a));
 
-	void *data = m_rb_tree_get_data(a);
-	enum _e_color color = m_rb_tree_get_color(a);
 	struct s_rb_tree *b = m_rb_tree_get_left(a);
-	struct s_rb_tree *a_right = m_rb_tree_get_right(a);
-	struct s_rb_tree *d = m_rb_tree_get_left(b);
-	struct s_rb_tree *c = m_rb_tree_get_right(a);
+	struct s_rb_tree *e = m_rb_tree_get_right(b);
 
-	/* in that case (a) -> (b) */
-	m_rb_tree_set_data(a, m_rb_tree_get_data(b));
-	m_rb_tree_set_color(a, m_rb_tree_get_color(b));
-	m_rb_tree_set_left(a, m_rb_tree_get_left(b));
-	m_rb_tree_set_right(a, b);
-	m_rb_tree_set_parent(d, a);
+	m_rb_tree_set_left(a, e);
+	m_rb_tree_set_parent(e, a);
+	_s_rb_tree_transplant(root, a, b);
+	m_rb_tree_set_right(b, a);
+	m_rb_tree_set_parent(a, b);
 
-	/* in that case (b) -> (a) */
-	m_rb_tree_set_data(b, data);
-	m_rb_tree_set_color(b, color);
-	m_rb_tree_set_left(b, m_rb_tree_get_right(b));
-	m_rb_tree_set_right(b, a_right);
-	m_rb_tree_set_parent(c, b);
+	/* b now holds what a used to hold */
+	b->size = a->size;
+	m_rb_tree_update_size(a);
 }
 
-
 /**
  * Exemple :
  *          a              c
@@ -73,30 +101,62 @@ void _s_rb_tree_right_rotate(struct s_rb_tree *a)
  *        b   c   =>     a   e
  *           / \        / \
  *          d   e      b   d
- * the content of C/D/E stay unchanged after the rotation
+ * the nodes are relinked, every data stay in its own node
  */
-void _s_rb_tree_left_rotate(struct s_rb_tree *a)
+void _s_rb_tree_left_rotate(struct s_rb_tree **root, struct s_rb_tree *a)
 {
 	m_return_if_fail(a);
+	m_return_if_fail(m_rb_tree_get_right(a));
 
-	void *data = m_rb_tree_get_data(a);
-	enum _e_color color = m_rb_tree_get_color(a);
 	struct s_rb_tree *c = m_rb_tree_get_right(a);
-	struct s_rb_tree *a_left = m_rb_tree_get_left(a);
-	struct s_rb_tree *b = m_rb_tree_get_left(a);
-	struct s_rb_tree *e = m_rb_tree_get_right(c);
+	struct s_rb_tree *d = m_rb_tree_get_left(c);
 
-	/* in that case (a) -> (c) */
-	m_rb_tree_set_data(a, m_rb_tree_get_data(c));
-	m_rb_tree_set_color(a, m_rb_tree_get_color(c));
-	m_rb_tree_set_left(a, c);
-	m_rb_tree_set_right(a, m_rb_tree_get_right(c));
-	m_rb_tree_set_parent(e, a);
+	m_rb_tree_set_right(a, d);
+	m_rb_tree_set_parent(d, a);
+	_s_rb_tree_transplant(root, a, c);
+	m_rb_tree_set_left(c, a);
+	m_rb_tree_set_parent(a, c);
+
+	/* c now holds what a used to hold */
+	c->size = a->size;
+	m_rb_tree_update_size(a);
+}
+
+/**
+ * The subtree of a node covers the data between its nearest ancestor reached
+ * from the right (lower bound) and its nearest ancestor reached from the left
+ * (upper bound). Only the bound on the side of data is checked, the other one
+ * is already satisfied by the node itself. The climb is done without any
+ * comparison on the other side, so a sorted stream (hint on the last node
+ * added) costs a constant number of comparisons.
+ */
+struct s_rb_tree *_s_rb_tree_finger(struct s_rb_tree *hint,
+	t_compare_func cmp, void *data)
+{
+	struct s_rb_tree *x = hint;
+	struct s_rb_tree *y;
+	struct s_rb_tree *p;
 
-	 /* in that case (c) -> (a) */
-	m_rb_tree_set_data(c, data);
-	m_rb_tree_set_color(c, color);
-	m_rb_tree_set_right(c, m_rb_tree_get_left(c));
-	m_rb_tree_set_left(c, a_left);
-	m_rb_tree_set_parent(b, c);
+	if (cmp(m_rb_tree_get_data(x), data) <= 0) {
+		for (;;) {
+			/* upper bound: first ancestor reached from the left */
+			for (y = x, p = m_rb_tree_get_parent(y);
+				p && m_rb_tree_is_right(p, y);
+				y = p, p = m_rb_tree_get_parent(p));
+			if (!p || cmp(m_rb_tree_get_data(p), data) > 0)
+				break;
+			x = p;
+		}
+	} else {
+		for (;;) {
+			/* lower bound: first ancestor reached from the right */
+			for (y = x, p = m_rb_tree_get_parent(y);
+				p && m_rb_tree_is_left(p, y);
+				y = p, p = m_rb_tree_get_parent(p));
+			if (!p || cmp(m_rb_tree_get_data(p), data) < 0)
+				break;
+			x = p;
+		}
+	}
+	return x;
 }
@@ -17,33 +17,56 @@
 #ifndef _TOOLS_S_RB_TREE_PRIVATE_H_
 # define _TOOLS_S_RB_TREE_PRIVATE_H_
 
+# include <stddef.h>
 # include "tree/s_rb_tree.h"
 
 /**
- * @brief Color for a specific node
+ * @brief Color for a specific node, stored in the low bit of its parent link
  */
 enum _e_color {
 	_e_red,
-	_e_black,
-	_e_d_black
+	_e_black
 };
 
 /**
- * @brief The binary search tree structure
+ * @brief The binary search tree structure. The color shares a word with the
+ * parent pointer (nodes are at least 4 bytes aligned) and a node of a pool
+ * keeps its index instead of a pointer on the pool, so a node takes 40 bytes.
  * @param data: user data stored
- * @param color: the color associate to the node
- * @param parent: parent node
+ * @param parent_color: parent node, the low bit holding the color
  * @param left: left child
  * @param right: right child
+ * @param size: number of nodes of the subtree rooted on that node
+ * @param slot: 1 + index of the node into its pool, 0 if the node is
+ * allocated alone
  */
 struct s_rb_tree {
 	void *data;
-	enum _e_color color;
-	struct s_rb_tree *parent;
+	uintptr_t parent_color;
 	struct s_rb_tree *left;
 	struct s_rb_tree *right;
+	uint32_t size;
+	uint32_t slot;
 };
 
+/**
+ * @brief A block of nodes allocated at once by the bulk builders, released
+ * with its last node
+ * @param refs: number of nodes of the block still in use
+ * @param nodes: the nodes
+ */
+struct _s_rb_tree_pool {
+	uint32_t refs;
+	struct s_rb_tree nodes[];
+};
+
+/**
+ * @brief A convenience macro to get the pool holding a node (slot not 0)
+ */
+# define m_rb_tree_get_pool(tree) \
+	((struct _s_rb_tree_pool *)((char *)((tree) - ((tree)->slot - 1)) - \
+		offsetof(struct _s_rb_tree_pool, nodes)))
+
 /**
  * @brief A convenience macro to get the data in an element.
  */
@@ -52,7 +75,13 @@ struct s_rb_tree {
 /**
  * @brief A convenience macro to get the data in an element.
  */
-# define m_rb_tree_get_color(tree) ((tree) ? (tree)->color : _e_black)
+# define m_rb_tree_get_color(tree) \
+	((tree) ? (enum _e_color)((tree)->parent_color & 1) : _e_black)
+
+/**
+ * @brief A convenience macro to get the size of the subtree of a node.
+ */
+# define m_rb_tree_get_size(tree) ((tree) ? (tree)->size : 0)
 
 /**
  * @brief A convenience macro to get the left element of a node.
@@ -67,7 +96,9 @@ struct s_rb_tree {
 /**
  * @brief A convenience macro to get the parent node of a node
  */
-# define m_rb_tree_get_parent(tree) ((tree) ? (tree)->parent : NULL)
+# define m_rb_tree_get_parent(tree) \
+	((tree) ? (struct s_rb_tree *)((tree)->parent_color & ~(uintptr_t)1) : \
+		NULL)
 
 /**
  * @brief A convenience macro to get the grand parent node of a node
@@ -98,7 +129,7 @@ struct s_rb_tree {
 	((parent) ? (parent)->right == node : 0)
 
 # define m_rb_tree_is_black(node) \
-	((node)->color == _e_black || (node)->color == _e_d_black)
+	(m_rb_tree_get_color(node) == _e_black)
 
 /**
  * @brief A convenience macro to change the data of a specific node
@@ -117,7 +148,21 @@ struct s_rb_tree {
 # define m_rb_tree_set_color(tree, col) { \
 	do { \
 		if (tree) { \
-			(tree)->color = col; \
+			(tree)->parent_color = ((tree)->parent_color & \
+				~(uintptr_t)1) | (uintptr_t)(col); \
+		} \
+	} while (0); \
+}
+
+/**
+ * @brief A convenience macro to recompute the subtree size of a node from its
+ * children
+ */
+# define m_rb_tree_update_size(tree) { \
+	do { \
+		if (tree) { \
+			(tree)->size = m_rb_tree_get_size((tree)->left) + \
+				m_rb_tree_get_size((tree)->right) + 1; \
 		} \
 	} while (0); \
 }
@@ -128,7 +173,8 @@ struct s_rb_tree {
 # define m_rb_tree_set_parent(tree, node) { \
 	do { \
 		if (tree) { \
-			(tree)->parent = (node); \
+			(tree)->parent_color = (uintptr_t)(node) | \
+				((tree)->parent_color & 1); \
 		} \
 	} while (0); \
 }
@@ -155,18 +201,6 @@ struct s_rb_tree {
 	} while (0); \
 }
 
-/**
- * @brief A convenience macro to switch data from dst to src
- */
-# define m_rb_tree_switch_data(dst, src, destroy) { \
-	do { \
-		if (destroy) { \
-			destroy(m_rb_tree_get_data(dst)); \
-		} \
-		m_rb_tree_set_data(dst, m_rb_tree_get_data(src)); \
-	} while (0); \
-}
-
 /**
  * @brief Get the uncle of a specific node
  * @param tree[in] : node to browse
@@ -174,18 +208,67 @@ struct s_rb_tree {
  */
 struct s_rb_tree *_s_rb_tree_get_uncle(struct s_rb_tree *tree);
 
+/**
+ * @brief Release a node unlinked from its tree
+ * @param tree[in] : node to release
+ */
+void _s_rb_tree_free(struct s_rb_tree *tree);
+
+/**
+ * @brief Change the subtree size of a node and all its ancestors
+ * @param tree[in] : first node to update
+ * @param delta[in] : number of nodes added (or removed if negative)
+ */
+void _s_rb_tree_add_size(struct s_rb_tree *tree, int32_t delta);
+
+/**
+ * @brief Put a subtree at the place of another one in the parent of the later
+ * @param root[in] : root of the tree, updated if u was the root
+ * @param u[in] : node replaced
+ * @param v[in] : replacing node (may be NULL)
+ */
+void _s_rb_tree_transplant(struct s_rb_tree **root, struct s_rb_tree *u,
+	struct s_rb_tree *v);
+
 /**
  * @brief Perform a right rotate operation on node
- * @param node[in] : node to rotate
- * @return return the new root
+ * @param root[in] : root of the tree, updated if a was the root
+ * @param a[in] : node to rotate, with a left child
  */
-void _s_rb_tree_right_rotate(struct s_rb_tree *a);
+void _s_rb_tree_right_rotate(struct s_rb_tree **root, struct s_rb_tree *a);
 
 /**
  * @brief Perform a left rotate operation on node
- * @param node[in] : node to rotate
- * @return the new root of that rotation
+ * @param root[in] : root of the tree, updated if a was the root
+ * @param a[in] : node to rotate, with a right child
+ */
+void _s_rb_tree_left_rotate(struct s_rb_tree **root, struct s_rb_tree *a);
+
+/**
+ * @brief Rearrange the tree to be a valid red/black tree
+ * @param root[in] : root of the tree, updated by the rotations
+ * @param x[in] : newly added node (red)
+ */
+void _s_rb_tree_rearrange(struct s_rb_tree **root, struct s_rb_tree *x);
+
+/**
+ * @brief Unlink a node from the tree and rebalance it. A node with two
+ * children is replaced by its successor node (nodes are relinked, the data
+ * never move from one node to another).
+ * @param root[in] : root of the tree
+ * @param v[in] : node to unlink
+ */
+void _s_rb_tree_unlink(struct s_rb_tree **root, struct s_rb_tree *v);
+
+/**
+ * @brief Climb from a node up to the lowest ancestor whose subtree covers the
+ * place of a data, the descent can then start from there instead of the root
+ * @param hint[in] : node to start from
+ * @param cmp[in] : compare element function
+ * @param data[in] : data to place
+ * @return the node to descend from
  */
-void _s_rb_tree_left_rotate(struct s_rb_tree *a);
+struct s_rb_tree *_s_rb_tree_finger(struct s_rb_tree *hint,
+	t_compare_func cmp, void *data);
 
 #endif /* !_TOOLS_S_RB_TREE_PRIVATE_H_ */
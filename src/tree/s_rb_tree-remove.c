@@ -15,34 +15,17 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
+#include "m_alloc.h"
 #include "m_utils.h"
 
-/**
- * @brief Convenience macro to delete only one node without reccursion
- * @param node[in] : node to delete
- * @param operator[in] : user data deletion operator
- */
-#define m_rb_tree_delete_single(node, operator) { \
-	(node)->left = (node)->right = NULL; \
-	if (operator) \
-		s_rb_tree_delete_full((node), (operator)); \
-	else \
-		s_rb_tree_delete(node); \
-}
-
-/**
- * @brief Binary search tree remove function definition
- */
-static struct s_rb_tree *_s_bs_tree_remove(struct s_rb_tree *v,
-	t_compare_func cmp, t_destroy_func destroy, void *data);
-
 /**
  * @brief Get the minimum data value from the tree according to the given
  * tree
  * @param btree[in] : root tree to search
  * @return a valid tree pointer on succes, NULL on error
  */
-struct s_rb_tree *_s_bs_tree_find_min(struct s_rb_tree *v)
+static struct s_rb_tree *_s_bs_tree_find_min(struct s_rb_tree *v)
 {
 	m_return_val_if_fail(v, v);
 
@@ -54,258 +37,143 @@ struct s_rb_tree *_s_bs_tree_find_min(struct s_rb_tree *v)
 }
 
 /**
- * @brief Use for implementing the case 2)
- * @param v[in] : node to remove
- * @param u[in] : child node of v
- * @param destroy[in] : user destroy function
- * @return the modified v node or NULL
- */
-struct s_rb_tree *_s_bs_tree_switch(struct s_rb_tree *v,
-	struct s_rb_tree *u, t_destroy_func destroy)
-{
-	m_return_val_if_fail(v, v);
-
-	if (u) {
-		m_rb_tree_set_data(v, m_rb_tree_get_data(u));
-		m_rb_tree_set_color(v, _e_black);
-		m_rb_tree_set_left(v, m_rb_tree_get_left(u));
-		m_rb_tree_set_parent(m_rb_tree_get_left(u), v);
-		m_rb_tree_set_right(v, m_rb_tree_get_right(u));
-		m_rb_tree_set_parent(m_rb_tree_get_right(u), v);
-		m_rb_tree_delete_single(u, NULL);
-		return v;
-	} else {
-		if (m_rb_tree_is_left(m_rb_tree_get_parent(v), v)) {
-			m_rb_tree_set_left(m_rb_tree_get_parent(v), NULL);
-		} else if (m_rb_tree_is_right(m_rb_tree_get_parent(v), v)) {
-			m_rb_tree_set_right(m_rb_tree_get_parent(v), NULL);
-		}
-		m_rb_tree_delete_single(v, destroy);
-		return NULL;
-	}
-}
-
-/**
- * @brief Convenient macro to check if we reach the case a)
- * @param s[in] : sibling node of v (node to remove)
- */
-#define m_rb_tree_is_black_sibling_red_child(s) \
-	(m_rb_tree_get_color(s) == _e_black && \
-		(m_rb_tree_get_color(m_rb_tree_get_left(s)) == _e_red || \
-		m_rb_tree_get_color(m_rb_tree_get_right(s)) == _e_red))
-
-/**
- * @brief Perform the case a)
- * @param s[in] : sibling node of v (node to remove)
- */
-static void _s_rb_tree_black_sibling_red_child(struct s_rb_tree *s)
-{
-	/* (i) left left case */
-	if (m_rb_tree_is_left(m_rb_tree_get_parent(s), s) &&
-		m_rb_tree_get_color(m_rb_tree_get_left(s)) == _e_red) {
-ll_case:
-		m_rb_tree_set_color(s, _e_red);
-		m_rb_tree_set_color(m_rb_tree_get_parent(s), _e_black);
-		m_rb_tree_set_color(m_rb_tree_get_left(s), _e_black);
-		_s_rb_tree_right_rotate(m_rb_tree_get_parent(s));
-	/* (ii) left right case */
-	} else if (m_rb_tree_is_left(m_rb_tree_get_parent(s), s) &&
-		m_rb_tree_get_color(m_rb_tree_get_right(s)) == _e_red) {
-		_s_rb_tree_left_rotate(s);
-		goto ll_case;
-	/* (iii) right right case */
-	} else if (m_rb_tree_is_right(m_rb_tree_get_parent(s), s) &&
-		m_rb_tree_get_color(m_rb_tree_get_right(s)) == _e_red) {
-rr_case:
-		m_rb_tree_set_color(s, _e_red);
-		m_rb_tree_set_color(m_rb_tree_get_parent(s), _e_black);
-		m_rb_tree_set_color(m_rb_tree_get_right(s), _e_black);
-		_s_rb_tree_left_rotate(m_rb_tree_get_parent(s));
-	} else if (m_rb_tree_is_right(m_rb_tree_get_parent(s), s) &&
-		m_rb_tree_get_color(m_rb_tree_get_left(s)) == _e_red) {
-		_s_rb_tree_right_rotate(s);
-		goto rr_case;
-	}
-}
-
-/**
- * @brief Convenient macro to check if we reach the case b)
+ * @brief Convenient macro to check if both children of a node are black
  * @param s[in] : sibling node of v (node to remove)
  */
-#define m_rb_tree_is_black_sibling_black_childs(s) \
-	(m_rb_tree_get_color(s) == _e_black && \
-		m_rb_tree_get_color(m_rb_tree_get_left(s)) == _e_black && \
-		m_rb_tree_get_color(m_rb_tree_get_right(s)) == _e_black)
+#define m_rb_tree_is_black_childs(s) \
+	(m_rb_tree_is_black(m_rb_tree_get_left(s)) && \
+		m_rb_tree_is_black(m_rb_tree_get_right(s)))
 
 /**
- * @brief Perform the case c)
- * @param u[in] : child node of v (node to remove)
- * @param s[in] : sibling of u
+ * @brief Reduce double black conflict into the tree: x carries the black
+ * of the node removed on top of its own color.
+ * @param root[in] : root of the tree, updated by the rotations
+ * @param x[in] : node taking the place of the node removed (possibly NULL)
+ * @param p[in] : parent of x
  */
-static void _s_rb_tree_red_sibling(struct s_rb_tree *u, struct s_rb_tree *s)
+static void _s_rb_tree_reduce_d_black(struct s_rb_tree **root,
+	struct s_rb_tree *x, struct s_rb_tree *p)
 {
-	m_return_if_fail(u);
-	m_return_if_fail(s);
-
-	m_rb_tree_set_color(u, _e_red);
-	m_rb_tree_set_color(s, _e_black);
-
-	/* (i) */
-	if (m_rb_tree_is_left(u, s)) {
-		_s_rb_tree_right_rotate(m_rb_tree_get_parent(u));
-	/* (ii) */
-	} else {
-		_s_rb_tree_left_rotate(m_rb_tree_get_parent(u));
-	}
-	m_rb_tree_set_color(s, _e_red);
-	m_rb_tree_set_color(u, _e_black);
-}
-
-/**
- * @brief Reduce double black conflict into the tree (apply case 3)
- * @param u[in] : child of node (possibly older v)
- */
-static void _s_rb_tree_reduce_d_black(struct s_rb_tree *v)
-{
-	m_return_if_fail(v);
-
-	/* 3) */
-	while (m_rb_tree_get_color(v) == _e_d_black) {
-		struct s_rb_tree *s = m_rb_tree_get_sibling(v);
-
-		/* a) */
-		if (m_rb_tree_is_black_sibling_red_child(s)) {
-			_s_rb_tree_black_sibling_red_child(s);
-			m_rb_tree_set_color(v, _e_black);
-		/* b) */
-		} else if (m_rb_tree_is_black_sibling_black_childs(s)) {
-			struct s_rb_tree *p = m_rb_tree_get_parent(v);
-			m_rb_tree_set_color(s, _e_red);
-			m_rb_tree_set_color(v, _e_black);
-			v = m_rb_tree_get_parent(v);
-			if (m_rb_tree_get_color(p) == _e_black) {
-				m_rb_tree_set_color(v, _e_d_black);
-			} else {
-				m_rb_tree_set_color(v, _e_black);
+	while (x != *root && m_rb_tree_is_black(x)) {
+		if (x == m_rb_tree_get_left(p)) {
+			struct s_rb_tree *s = m_rb_tree_get_right(p);
+
+			/* c) red sibling: rotate to get a black one */
+			if (m_rb_tree_get_color(s) == _e_red) {
+				m_rb_tree_set_color(s, _e_black);
+				m_rb_tree_set_color(p, _e_red);
+				_s_rb_tree_left_rotate(root, p);
+				s = m_rb_tree_get_right(p);
+			}
+			/* b) black sibling with black children: move up */
+			if (m_rb_tree_is_black_childs(s)) {
+				m_rb_tree_set_color(s, _e_red);
+				x = p;
+				p = m_rb_tree_get_parent(x);
+				continue;
+			}
+			/* a) black sibling with a red child (right left case) */
+			if (m_rb_tree_is_black(m_rb_tree_get_right(s))) {
+				m_rb_tree_set_color(m_rb_tree_get_left(s), _e_black);
+				m_rb_tree_set_color(s, _e_red);
+				_s_rb_tree_right_rotate(root, s);
+				s = m_rb_tree_get_right(p);
+			}
+			/* a) right right case */
+			m_rb_tree_set_color(s, m_rb_tree_get_color(p));
+			m_rb_tree_set_color(p, _e_black);
+			m_rb_tree_set_color(m_rb_tree_get_right(s), _e_black);
+			_s_rb_tree_left_rotate(root, p);
+			x = *root;
+		} else {
+			struct s_rb_tree *s = m_rb_tree_get_left(p);
+
+			/* c) red sibling: rotate to get a black one */
+			if (m_rb_tree_get_color(s) == _e_red) {
+				m_rb_tree_set_color(s, _e_black);
+				m_rb_tree_set_color(p, _e_red);
+				_s_rb_tree_right_rotate(root, p);
+				s = m_rb_tree_get_left(p);
+			}
+			/* b) black sibling with black children: move up */
+			if (m_rb_tree_is_black_childs(s)) {
+				m_rb_tree_set_color(s, _e_red);
+				x = p;
+				p = m_rb_tree_get_parent(x);
+				continue;
+			}
+			/* a) black sibling with a red child (left right case) */
+			if (m_rb_tree_is_black(m_rb_tree_get_left(s))) {
+				m_rb_tree_set_color(m_rb_tree_get_right(s),
+					_e_black);
+				m_rb_tree_set_color(s, _e_red);
+				_s_rb_tree_left_rotate(root, s);
+				s = m_rb_tree_get_left(p);
 			}
-		/* c) */
-		} else if (m_rb_tree_get_color(s) == _e_red) {
-			_s_rb_tree_red_sibling(v, s);
+			/* a) left left case */
+			m_rb_tree_set_color(s, m_rb_tree_get_color(p));
+			m_rb_tree_set_color(p, _e_black);
+			m_rb_tree_set_color(m_rb_tree_get_left(s), _e_black);
+			_s_rb_tree_right_rotate(root, p);
+			x = *root;
 		}
 	}
+	m_rb_tree_set_color(x, _e_black);
 }
 
-/**
- * @brief Remove leaf from the tree
- * @param v[in] : node to remove
- * @param destroy[in] : user data destroy function
- * @return NULL
- */
-static struct s_rb_tree *_s_rb_tree_remove_no_child(struct s_rb_tree *v,
-	t_destroy_func destroy)
+void _s_rb_tree_unlink(struct s_rb_tree **root, struct s_rb_tree *v)
 {
-	m_return_val_if_fail(v, v);
-
-	if (m_rb_tree_is_black(v)) {
-		m_rb_tree_set_color(v, _e_d_black);
-		_s_rb_tree_reduce_d_black(v);
-	}
-	if (m_rb_tree_is_left(m_rb_tree_get_parent(v), v)) {
-		m_rb_tree_set_left(m_rb_tree_get_parent(v), NULL);
-	} else {
-		m_rb_tree_set_right(m_rb_tree_get_parent(v), NULL);
-	}
-	m_rb_tree_delete_single(v, destroy);
-	return NULL;
-}
-
-/**
- * @brief Remove one child node from the tree
- * @param v[in] : node to remove
- * @param destroy[in] : user data destroy function
- * @return v
- */
-static struct s_rb_tree *_s_rb_tree_remove_one_child(struct s_rb_tree *v,
-	t_destroy_func destroy)
-{
-	m_return_val_if_fail(v, v);
-
-	struct s_rb_tree *tmp = m_rb_tree_get_left(v) ?
-		m_rb_tree_get_left(v) : m_rb_tree_get_right(v);
-
-	m_rb_tree_switch_data(v, tmp, destroy);
-	if (m_rb_tree_is_black(v) && m_rb_tree_is_black(tmp)) {
-		m_rb_tree_set_color(tmp, _e_d_black);
-		_s_rb_tree_reduce_d_black(v);
-	}
-	m_rb_tree_set_color(tmp, _e_black);
-	if (m_rb_tree_is_left(m_rb_tree_get_parent(v), v)) {
-		m_rb_tree_set_left(m_rb_tree_get_parent(v), tmp);
-		m_rb_tree_set_parent(tmp, m_rb_tree_get_parent(v));
+	enum _e_color color = m_rb_tree_get_color(v);
+	struct s_rb_tree *x;
+	struct s_rb_tree *p;
+
+	if (!m_rb_tree_get_left(v) || !m_rb_tree_get_right(v)) {
+		/* 1) no or one child: the child takes the place of v */
+		x = m_rb_tree_get_left(v) ? m_rb_tree_get_left(v) :
+			m_rb_tree_get_right(v);
+		p = m_rb_tree_get_parent(v);
+		_s_rb_tree_add_size(p, -1);
+		_s_rb_tree_transplant(root, v, x);
 	} else {
-		m_rb_tree_set_right(m_rb_tree_get_parent(v), tmp);
-		m_rb_tree_set_parent(tmp, m_rb_tree_get_parent(v));
+		/* 2) two children: the successor takes the place of v */
+		struct s_rb_tree *y = _s_bs_tree_find_min(m_rb_tree_get_right(v));
+		color = m_rb_tree_get_color(y);
+		x = m_rb_tree_get_right(y);
+		_s_rb_tree_add_size(m_rb_tree_get_parent(y), -1);
+
+		if (m_rb_tree_get_parent(y) == v) {
+			p = y;
+		} else {
+			p = m_rb_tree_get_parent(y);
+			_s_rb_tree_transplant(root, y, x);
+			m_rb_tree_set_right(y, m_rb_tree_get_right(v));
+			m_rb_tree_set_parent(m_rb_tree_get_right(y), y);
+		}
+		_s_rb_tree_transplant(root, v, y);
+		m_rb_tree_set_left(y, m_rb_tree_get_left(v));
+		m_rb_tree_set_parent(m_rb_tree_get_left(y), y);
+		m_rb_tree_set_color(y, m_rb_tree_get_color(v));
+		y->size = v->size;
 	}
-	m_rb_tree_delete_single(v, NULL);
-	return tmp;
-}
 
-/**
- * @brief Remove one child node from the tree
- * @param v[in] : node to remove
- * @param destroy[in] : user data destroy function
- * @return v
- */
-static struct s_rb_tree *_s_rb_tree_remove_two_child(struct s_rb_tree *v,
-	t_compare_func cmp, t_destroy_func destroy)
-{
-	m_return_val_if_fail(v, v);
-
-	struct s_rb_tree *tmp = _s_bs_tree_find_min(m_rb_tree_get_left(v));
-
-	m_rb_tree_switch_data(v, tmp, destroy);
-	m_rb_tree_set_color(tmp, _e_d_black);
-	_s_bs_tree_remove(m_rb_tree_get_left(v), cmp, NULL,
-		m_rb_tree_get_data(tmp));
-
-	return v;
+	/* 3) removing a black node breaks the black height */
+	if (color == _e_black)
+		_s_rb_tree_reduce_d_black(root, x, p);
 }
 
-/**
- * @brief Remove core algorithm. Apply a binary search tree remove algorith +
- * rearrangement process
- * @param v[in] : node to delete
- * @param cmp[in] : user compare function
- * @param del[in] : user destroy function
- * @param data[in] : data to find and remove
- * @return the possibly changed tree root
- */
-static struct s_rb_tree *_s_bs_tree_remove(struct s_rb_tree *v,
-	t_compare_func cmp, t_destroy_func destroy, void *data)
+int s_rb_tree_remove_node(struct s_rb_tree **tree, struct s_rb_tree *node,
+	t_destroy_func destroy)
 {
-	m_return_val_if_fail(v, v);
-	m_return_val_if_fail(cmp, v);
-
-	int ret = cmp(m_rb_tree_get_data(v), data);
-	if (ret == 0) {
-		if (!m_rb_tree_get_left(v) && !m_rb_tree_get_right(v)) {
-			return _s_rb_tree_remove_no_child(v, destroy);
-		} else if (!m_rb_tree_get_left(v) ||
-			!m_rb_tree_get_right(v)) {
-			return _s_rb_tree_remove_one_child(v, destroy);
-		} else {
-			return _s_rb_tree_remove_two_child(v, cmp, destroy);
-		}
-	} else if (ret > 0) {
-		if (m_rb_tree_get_left(v))
-			_s_bs_tree_remove(m_rb_tree_get_left(v), cmp, destroy,
-				data);
-	} else {
-		if (m_rb_tree_get_right(v))
-			_s_bs_tree_remove(m_rb_tree_get_right(v), cmp,
-				destroy, data);
-	}
-	return v;
+	m_stats_scope(e_stats_rb_tree_remove);
+	m_return_val_if_fail(tree, -EINVAL);
+	m_return_val_if_fail(*tree, -EINVAL);
+	m_return_val_if_fail(node, -EINVAL);
+
+	_s_rb_tree_unlink(tree, node);
+	if (destroy)
+		destroy(m_rb_tree_get_data(node));
+	_s_rb_tree_free(node);
+	return 0;
 }
 
 struct s_rb_tree *s_rb_tree_remove(struct s_rb_tree *v,
@@ -314,8 +182,8 @@ struct s_rb_tree *s_rb_tree_remove(struct s_rb_tree *v,
 	m_return_val_if_fail(v, v);
 	m_return_val_if_fail(compare, v);
 
-	v = _s_bs_tree_remove(v, compare, destroy, data);
-	if (v)
-		m_rb_tree_set_color(v, _e_black);
+	struct s_rb_tree *node = s_rb_tree_find(v, compare, data);
+	if (node)
+		s_rb_tree_remove_node(&v, node, destroy);
 	return v;
 }
@@ -15,8 +15,8 @@
  * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
  */
 #include <string.h>
-#include "queue/s_queue.h"
 #include "s_rb_tree-private.h"
+#include "stats/s_stats-private.h"
 #include "m_alloc.h"
 #include "m_utils.h"
 
@@ -28,7 +28,7 @@ void s_rb_tree_delete(struct s_rb_tree *tree)
 		s_rb_tree_delete(m_rb_tree_get_left(tree));
 	if (m_rb_tree_get_right(tree))
 		s_rb_tree_delete(m_rb_tree_get_right(tree));
-	_free(tree);
+	_s_rb_tree_free(tree);
 }
 
 void s_rb_tree_delete_full(struct s_rb_tree *tree, t_destroy_func destroy)
@@ -41,7 +41,7 @@ void s_rb_tree_delete_full(struct s_rb_tree *tree, t_destroy_func destroy)
 		s_rb_tree_delete_full(m_rb_tree_get_right(tree), destroy);
 	if (destroy)
 		destroy(m_rb_tree_get_data(tree));
-	_free(tree);
+	_s_rb_tree_free(tree);
 }
 
 /**
@@ -49,153 +49,313 @@ void s_rb_tree_delete_full(struct s_rb_tree *tree, t_destroy_func destroy)
  * find implementation
  * -----------------------------------------------------------------------------
  */
-/**
- * @brief Core function
- */
-static struct s_rb_tree *_s_rb_tree_nth_smallest(struct s_rb_tree *tree,
-	uint32_t nth, uint32_t k)
+uint32_t s_rb_tree_size(struct s_rb_tree *tree)
+{
+	return m_rb_tree_get_size(tree);
+}
+
+void *s_rb_tree_nth_smallest(struct s_rb_tree *tree, uint32_t nth)
 {
 	m_return_val_if_fail(tree, NULL);
 	m_return_val_if_fail(nth > 0, NULL);
 
-	struct s_rb_tree *data = (m_rb_tree_get_left(tree)) ?
-		_s_rb_tree_nth_smallest(m_rb_tree_get_left(tree), nth, k) :
-		NULL;
-
-	if (data)
-		return data;
-	else if (++k == nth)
-		return tree;
-
-	return (m_rb_tree_get_right(tree)) ?
-		_s_rb_tree_nth_smallest(m_rb_tree_get_right(tree), nth, k) :
-		data;
+	/* skip the subtrees holding fewer than nth elements */
+	while (tree) {
+		uint32_t left = m_rb_tree_get_size(m_rb_tree_get_left(tree));
+		if (nth <= left) {
+			tree = m_rb_tree_get_left(tree);
+		} else if (nth == left + 1) {
+			return m_rb_tree_get_data(tree);
+		} else {
+			nth -= left + 1;
+			tree = m_rb_tree_get_right(tree);
+		}
+	}
+	return NULL;
 }
 
-void *s_rb_tree_nth_smallest(struct s_rb_tree *tree, uint32_t nth)
+void *s_rb_tree_nth_biggest(struct s_rb_tree *tree, uint32_t nth)
 {
-	return m_rb_tree_get_data(_s_rb_tree_nth_smallest(tree, nth, 0));
+	m_return_val_if_fail(tree, NULL);
+	m_return_val_if_fail(nth > 0, NULL);
+
+	while (tree) {
+		uint32_t right = m_rb_tree_get_size(m_rb_tree_get_right(tree));
+		if (nth <= right) {
+			tree = m_rb_tree_get_right(tree);
+		} else if (nth == right + 1) {
+			return m_rb_tree_get_data(tree);
+		} else {
+			nth -= right + 1;
+			tree = m_rb_tree_get_left(tree);
+		}
+	}
+	return NULL;
 }
 
 /**
- * @brief Core function
+ * @brief Count the elements smaller than data, or not bigger if or_equal
  */
-static struct s_rb_tree *_s_rb_tree_nth_biggest(struct s_rb_tree *tree,
-	uint32_t nth, uint32_t k)
+static uint32_t _s_rb_tree_rank(struct s_rb_tree *tree, t_compare_func cmp,
+	void *data, uint8_t or_equal)
 {
-	m_return_val_if_fail(tree, NULL);
-	m_return_val_if_fail(nth > 0, NULL);
-
-	struct s_rb_tree *data = (m_rb_tree_get_right(tree)) ?
-		s_rb_tree_nth_biggest(m_rb_tree_get_right(tree), nth) : NULL;
+	uint32_t rank = 0;
+	while (tree) {
+		int ret = cmp(m_rb_tree_get_data(tree), data);
+		if (ret < 0 || (or_equal && ret == 0)) {
+			rank += m_rb_tree_get_size(m_rb_tree_get_left(tree)) + 1;
+			tree = m_rb_tree_get_right(tree);
+		} else {
+			tree = m_rb_tree_get_left(tree);
+		}
+	}
+	return rank;
+}
 
-	if (data)
-		return data;
-	else if (++k == nth)
-		return tree;
+uint32_t s_rb_tree_rank(struct s_rb_tree *tree, t_compare_func cmp,
+	void *data)
+{
+	m_return_val_if_fail(cmp, 0);
 
-	return (m_rb_tree_get_left(tree)) ?
-		s_rb_tree_nth_biggest(m_rb_tree_get_left(tree), nth) : data;
+	return _s_rb_tree_rank(tree, cmp, data, 0);
 }
 
-void *s_rb_tree_nth_biggest(struct s_rb_tree *tree, uint32_t nth)
+uint32_t s_rb_tree_count_range(struct s_rb_tree *tree, t_compare_func cmp,
+	void *lo, void *hi)
 {
-	return m_rb_tree_get_data(_s_rb_tree_nth_biggest(tree, nth, 0));
+	m_return_val_if_fail(cmp, 0);
+
+	if (cmp(lo, hi) > 0)
+		return 0;
+	return _s_rb_tree_rank(tree, cmp, hi, 1) -
+		_s_rb_tree_rank(tree, cmp, lo, 0);
 }
 
 int s_rb_tree_exist(struct s_rb_tree *tree, t_compare_func cmp, void *data)
 {
+	m_stats_scope(e_stats_rb_tree_exist);
 	m_return_val_if_fail(tree, -EINVAL);
 	m_return_val_if_fail(cmp, -EINVAL);
 
-	int ret = cmp(m_rb_tree_get_data(tree), data);
-	if (ret == 0)
-		return 0;
-	else if (ret > 0)
-		return (m_rb_tree_get_left(tree)) ?
-			s_rb_tree_exist(m_rb_tree_get_left(tree), cmp, data) :
-			-EAGAIN;
-	else
-		return (m_rb_tree_get_right(tree)) ?
-			s_rb_tree_exist(m_rb_tree_get_right(tree), cmp,
-				data) : -EAGAIN;
+	return (s_rb_tree_find(tree, cmp, data)) ? 0 : -EAGAIN;
 }
 
 /**
  * -----------------------------------------------------------------------------
- * foreach implementation
+ * handle implementation
  * -----------------------------------------------------------------------------
  */
+struct s_rb_tree *s_rb_tree_find(struct s_rb_tree *tree, t_compare_func cmp,
+	void *data)
+{
+	m_return_val_if_fail(cmp, NULL);
+
+	while (tree) {
+		int ret = cmp(m_rb_tree_get_data(tree), data);
+		if (ret == 0)
+			break;
+		tree = (ret > 0) ? m_rb_tree_get_left(tree) :
+			m_rb_tree_get_right(tree);
+	}
+	return tree;
+}
 
-/**
- * @brief Pre-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
- * @param tree[in] : tree to visit
- * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
- * @return 0 on success, errno on error
- */
-static int _s_rb_tree_depth_pre(struct s_rb_tree *tree,
-	t_foreach_func foreach, void *user_data)
+struct s_rb_tree *s_rb_tree_find_hint(struct s_rb_tree *hint,
+	t_compare_func cmp, void *data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
+	m_return_val_if_fail(hint, NULL);
+	m_return_val_if_fail(cmp, NULL);
+
+	return s_rb_tree_find(_s_rb_tree_finger(hint, cmp, data), cmp, data);
+}
 
-	struct s_rb_tree *left = m_rb_tree_get_left(tree);
-	struct s_rb_tree *right = m_rb_tree_get_right(tree);
+void *s_rb_tree_data(const struct s_rb_tree *node)
+{
+	m_return_val_if_fail(node, NULL);
 
-	int ret = foreach(m_rb_tree_get_data(tree), user_data);
-	ret |= (left) ? _s_rb_tree_depth_pre(left, foreach, user_data) : 0;
-	ret |= (right) ? _s_rb_tree_depth_pre(right, foreach, user_data) : 0;
+	return node->data;
+}
 
-	return ret;
+struct s_rb_tree *s_rb_tree_first(struct s_rb_tree *tree)
+{
+	m_return_val_if_fail(tree, NULL);
+
+	while (m_rb_tree_get_left(tree))
+		tree = m_rb_tree_get_left(tree);
+	return tree;
+}
+
+struct s_rb_tree *s_rb_tree_last(struct s_rb_tree *tree)
+{
+	m_return_val_if_fail(tree, NULL);
+
+	while (m_rb_tree_get_right(tree))
+		tree = m_rb_tree_get_right(tree);
+	return tree;
+}
+
+struct s_rb_tree *s_rb_tree_next(struct s_rb_tree *node)
+{
+	m_return_val_if_fail(node, NULL);
+
+	if (m_rb_tree_get_right(node))
+		return s_rb_tree_first(m_rb_tree_get_right(node));
+
+	/* climb until we come from a left child */
+	struct s_rb_tree *parent = m_rb_tree_get_parent(node);
+	while (parent && m_rb_tree_is_right(parent, node)) {
+		node = parent;
+		parent = m_rb_tree_get_parent(node);
+	}
+	return parent;
+}
+
+struct s_rb_tree *s_rb_tree_prev(struct s_rb_tree *node)
+{
+	m_return_val_if_fail(node, NULL);
+
+	if (m_rb_tree_get_left(node))
+		return s_rb_tree_last(m_rb_tree_get_left(node));
+
+	/* climb until we come from a right child */
+	struct s_rb_tree *parent = m_rb_tree_get_parent(node);
+	while (parent && m_rb_tree_is_left(parent, node)) {
+		node = parent;
+		parent = m_rb_tree_get_parent(node);
+	}
+	return parent;
 }
 
 /**
- * @brief Post-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
- * @param tree[in] : tree to visit
- * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
- * @return 0 on success, errno on error
+ * -----------------------------------------------------------------------------
+ * bound implementation
+ * -----------------------------------------------------------------------------
  */
-static int _s_rb_tree_depth_post(struct s_rb_tree *tree,
-	t_foreach_func foreach, void *user_data)
+
+/**
+ * @brief Get the first node after data: the first not smaller one, or the
+ * first bigger one if strict
+ */
+static struct s_rb_tree *_s_rb_tree_bound(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data, uint8_t strict)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
+	struct s_rb_tree *bound = NULL;
+
+	while (tree) {
+		int ret = cmp(m_rb_tree_get_data(tree), data);
+		if (ret > 0 || (!strict && ret == 0)) {
+			bound = tree;
+			tree = m_rb_tree_get_left(tree);
+		} else {
+			tree = m_rb_tree_get_right(tree);
+		}
+	}
+	return bound;
+}
+
+struct s_rb_tree *s_rb_tree_lower_bound(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data)
+{
+	m_return_val_if_fail(cmp, NULL);
+
+	return _s_rb_tree_bound(tree, cmp, data, 0);
+}
+
+struct s_rb_tree *s_rb_tree_upper_bound(struct s_rb_tree *tree,
+	t_compare_func cmp, void *data)
+{
+	m_return_val_if_fail(cmp, NULL);
+
+	return _s_rb_tree_bound(tree, cmp, data, 1);
+}
 
-	struct s_rb_tree *left = m_rb_tree_get_left(tree);
-	struct s_rb_tree *right = m_rb_tree_get_right(tree);
+struct s_rb_tree *s_rb_tree_floor(struct s_rb_tree *tree, t_compare_func cmp,
+	void *data)
+{
+	m_return_val_if_fail(cmp, NULL);
+
+	struct s_rb_tree *floor = NULL;
+	while (tree) {
+		if (cmp(m_rb_tree_get_data(tree), data) <= 0) {
+			floor = tree;
+			tree = m_rb_tree_get_right(tree);
+		} else {
+			tree = m_rb_tree_get_left(tree);
+		}
+	}
+	return floor;
+}
 
-	int ret = (left) ? _s_rb_tree_depth_post(left, foreach, user_data) : 0;
-	ret |= (right) ? _s_rb_tree_depth_post(right, foreach, user_data) : 0;
-	ret |= foreach(m_rb_tree_get_data(tree), user_data);
+int s_rb_tree_foreach_range(struct s_rb_tree *tree, t_compare_func cmp,
+	void *lo, void *hi, t_foreach_func foreach, void *user_data)
+{
+	m_stats_scope(e_stats_rb_tree_foreach);
+	m_return_val_if_fail(cmp, -EINVAL);
+	m_return_val_if_fail(foreach, -EINVAL);
 
+	int ret = 0;
+	struct s_rb_tree *node = _s_rb_tree_bound(tree, cmp, lo, 0);
+	for (; node && cmp(m_rb_tree_get_data(node), hi) <= 0;
+		node = s_rb_tree_next(node))
+		ret |= foreach(m_rb_tree_get_data(node), user_data);
 	return ret;
 }
 
 /**
- * @brief In-order traversal visit each node in a tree by recursively visiting
- * each node in the left and right subtrees of the root.
+ * -----------------------------------------------------------------------------
+ * foreach implementation
+ * -----------------------------------------------------------------------------
+ */
+
+/**
+ * @brief Depth-first traversal following the parent links, without stack nor
+ * allocation. Each node is reached three times: from its parent, back from
+ * its left subtree and back from its right subtree; pre-order, in-order and
+ * post-order visit it respectively on the first, second and last time.
  * @param tree[in] : tree to visit
+ * @param type[in] : depth-first order
  * @param foreach[in] : foreach user callback
- * @param data[in] : user data pass through the callback
+ * @param user_data[in] : user data pass through the callback
  * @return 0 on success, errno on error
  */
-static int _s_rb_tree_depth_in(struct s_rb_tree *tree, t_foreach_func foreach,
-	void *user_data)
+static int _s_rb_tree_depth(struct s_rb_tree *tree, enum e_tree_browse type,
+	t_foreach_func foreach, void *user_data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
-
-	struct s_rb_tree *left = m_rb_tree_get_left(tree);
-	struct s_rb_tree *right = m_rb_tree_get_right(tree);
-
-	int ret = (left) ? _s_rb_tree_depth_post(left, foreach, user_data) : 0;
-	ret |= foreach(m_rb_tree_get_data(tree), user_data);
-	ret |= (right) ? _s_rb_tree_depth_post(right, foreach, user_data) : 0;
+	struct s_rb_tree *stop = m_rb_tree_get_parent(tree);
+	struct s_rb_tree *prev = stop;
+	struct s_rb_tree *node = tree;
+	int ret = 0;
 
+	while (node != stop) {
+		struct s_rb_tree *parent = m_rb_tree_get_parent(node);
+		struct s_rb_tree *left = m_rb_tree_get_left(node);
+		struct s_rb_tree *right = m_rb_tree_get_right(node);
+		struct s_rb_tree *next = parent;
+
+		if (prev == parent) {
+			if (type == e_tree_depth_pre)
+				ret |= foreach(m_rb_tree_get_data(node),
+					user_data);
+			if (left) {
+				next = left;
+				goto move;
+			}
+		}
+		if (prev == parent || (left && prev == left)) {
+			if (type == e_tree_depth_in)
+				ret |= foreach(m_rb_tree_get_data(node),
+					user_data);
+			if (right) {
+				next = right;
+				goto move;
+			}
+		}
+		if (type == e_tree_depth_post)
+			ret |= foreach(m_rb_tree_get_data(node), user_data);
+move:
+		prev = node;
+		node = next;
+	}
 	return ret;
 }
 
@@ -203,7 +363,9 @@ static int _s_rb_tree_depth_in(struct s_rb_tree *tree, t_foreach_func foreach,
  * @brief Contrasting with depth-first order is breadth-first order, which
  * always attempts to visit the node closest to the root that it has not already
  * visited. See breadth-first search for more information. Also called a
- * level-order traversal.
+ * level-order traversal. The pending nodes never include one another, so
+ * they never outnumber the leaves: a single ring of size / 2 + 1 slots is
+ * enough.
  * @param tree[in] : tree to visit
  * @param foreach[in] : foreach user callback
  * @param data[in] : user data pass through the callback
@@ -212,40 +374,43 @@ static int _s_rb_tree_depth_in(struct s_rb_tree *tree, t_foreach_func foreach,
 static int _s_rb_tree_breath(struct s_rb_tree *tree, t_foreach_func foreach,
 	void *data)
 {
-	m_return_val_if_fail(tree, -EINVAL);
-	m_return_val_if_fail(foreach, -EINVAL);
-
+	uint32_t capacity = m_rb_tree_get_size(tree) / 2 + 1;
+	struct s_rb_tree **ring = _malloc(capacity * sizeof(struct s_rb_tree *));
+	uint32_t head = 0;
+	uint32_t count = 1;
 	int ret = 0;
-	struct s_queue *queue = s_queue_new();
-	ret = s_queue_push(queue, tree);
 
-	while (!s_queue_empty(queue)) {
-		struct s_rb_tree *tmp = s_queue_pop(queue);
+	ring[0] = tree;
+	while (count) {
+		struct s_rb_tree *tmp = ring[head];
 		struct s_rb_tree *left = m_rb_tree_get_left(tmp);
 		struct s_rb_tree *right = m_rb_tree_get_right(tmp);
 
+		head = (head + 1 == capacity) ? 0 : head + 1;
+		count--;
 		ret |= foreach(m_rb_tree_get_data(tmp), data);
-		ret |= (left) ? s_queue_push(queue, left) : 0;
-		ret |= (right) ? s_queue_push(queue, right) : 0;
+		if (left)
+			ring[(head + count++) % capacity] = left;
+		if (right)
+			ring[(head + count++) % capacity] = right;
 	}
 
-	s_queue_delete(queue);
+	_free(ring);
 	return ret;
 }
 
 int s_rb_tree_foreach(struct s_rb_tree *tree, enum e_tree_browse type,
 	t_foreach_func foreach, void *user_data)
 {
+	m_stats_scope(e_stats_rb_tree_foreach);
 	m_return_val_if_fail(tree, -EINVAL);
 	m_return_val_if_fail(foreach, -EINVAL);
 
 	switch (type) {
 	case e_tree_depth_pre:
-		return _s_rb_tree_depth_pre(tree, foreach, user_data);
 	case e_tree_depth_post:
-		return _s_rb_tree_depth_post(tree, foreach, user_data);
 	case e_tree_depth_in:
-		return _s_rb_tree_depth_in(tree, foreach, user_data);
+		return _s_rb_tree_depth(tree, type, foreach, user_data);
 	case e_tree_breath:
 		return _s_rb_tree_breath(tree, foreach, user_data);
 	}
@@ -0,0 +1,88 @@
+/**
+ * This file is part of libtools
+ *
+ * libtools is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * libtools is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with libtools.  If not, see <http:www.gnu.org/licenses/>.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include "tree/s_rb_persist.h"
+
+#define _KEYS 64
+
+static int _compare(void *a, void *b)
+{
+	intptr_t x = (intptr_t)a;
+	intptr_t y = (intptr_t)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Apply an update to the current version and check the elements
+ * against a reference set
+ * @return the number of errors
+ */
+static int _step(struct s_rb_persist **version, uint8_t *set, uint8_t add,
+	intptr_t key)
+{
+	struct s_rb_persist *next = (add) ?
+		s_rb_persist_add(*version, _compare, (void *)key) :
+		s_rb_persist_remove(*version, _compare, (void *)key);
+	uint32_t size = 0;
+	int errors = 0;
+
+	s_rb_persist_release(*version);
+	*version = next;
+	set[key] = add;
+	for (intptr_t i = 0; i < _KEYS; i++) {
+		size += set[i];
+		if ((s_rb_persist_exist(next, _compare, (void *)i) == 0) !=
+			set[i])
+			errors++;
+	}
+	if (s_rb_persist_size(next) != size)
+		errors++;
+	return errors;
+}
+
+int main(void)
+{
+	/* adding an element twice used to break the erase path */
+	static const struct {
+		uint8_t add;
+		intptr_t key;
+	} sequence[] = {
+		{ 1, 3 }, { 1, 1 }, { 1, 0 }, { 0, 0 }, { 0, 2 }, { 0, 3 },
+		{ 1, 2 }, { 1, 1 }, { 0, 1 }, { 1, 0 }, { 0, 1 }, { 0, 2 }
+	};
+	struct s_rb_persist *version = NULL;
+	uint8_t set[_KEYS] = { 0 };
+	uint32_t seed = 1;
+	int errors = 0;
+
+	for (uint32_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); i++)
+		errors += _step(&version, set, sequence[i].add,
+			sequence[i].key);
+
+	for (uint32_t i = 0; i < 20000; i++) {
+		seed = seed * 1103515245 + 12345;
+		errors += _step(&version, set, (seed >> 16) & 1,
+			(seed >> 8) % _KEYS);
+	}
+
+	s_rb_persist_release(version);
+	if (errors)
+		fprintf(stderr, "s_rb_persist: %d errors\n", errors);
+	return errors ? 1 : 0;
+}